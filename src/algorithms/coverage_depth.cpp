@@ -1,4 +1,6 @@
 #include "coverage_depth.hpp"
+#include <fstream>
+#include <list>
 #include <bdsg/hash_graph.hpp>
 #include "algorithms/subgraph.hpp"
 #include <vg/io/stream.hpp>
@@ -204,6 +206,166 @@ pair<float, float> get_depth_from_index(const BinnedDepthIndex& depth_index, con
     return total;
 }
 
+bool BinnedDepthIndexParams::operator==(const BinnedDepthIndexParams& other) const {
+    return min_bin_size == other.min_bin_size && max_bin_size == other.max_bin_size &&
+        exp_growth_factor == other.exp_growth_factor && min_coverage == other.min_coverage &&
+        include_deletions == other.include_deletions && std_err == other.std_err;
+}
+
+BinnedDepthIndex binned_packed_depth_index(const Packer& packer, const vector<string>& path_names,
+                                           const BinnedDepthIndexParams& params) {
+    return binned_packed_depth_index(packer, path_names, params.min_bin_size, params.max_bin_size,
+                                     params.exp_growth_factor, params.min_coverage, params.include_deletions,
+                                     params.std_err);
+}
+
+bool PackedCoverageFingerprint::operator==(const PackedCoverageFingerprint& other) const {
+    return size == other.size && checksum == other.checksum;
+}
+
+PackedCoverageFingerprint packed_coverage_fingerprint(const Packer& packer) {
+    PackedCoverageFingerprint fingerprint;
+    fingerprint.size = packer.coverage_size();
+    // Sum a mix of each position and its coverage, so the positions can be
+    // visited in any order.
+    uint64_t checksum = 0;
+#pragma omp parallel for reduction(+:checksum)
+    for (size_t i = 0; i < fingerprint.size; ++i) {
+        uint64_t x = (uint64_t)i * 0x9e3779b97f4a7c15ull + packer.coverage_at_position(i);
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        checksum += x ^ (x >> 31);
+    }
+    fingerprint.checksum = checksum;
+    return fingerprint;
+}
+
+// magic number and version for the binned depth index file
+static const char BINNED_DEPTH_INDEX_MAGIC[8] = {'V', 'G', 'D', 'E', 'P', 'T', 'H', '2'};
+
+template<typename T>
+static void write_binary(ostream& out, const T& value) {
+    out.write((const char*)&value, sizeof(T));
+}
+
+template<typename T>
+static void read_binary(istream& in, T& value) {
+    in.read((char*)&value, sizeof(T));
+}
+
+void save_binned_depth_index(const BinnedDepthIndex& depth_index, const BinnedDepthIndexParams& params,
+                             const PackedCoverageFingerprint& fingerprint, const string& filename) {
+    ofstream out(filename, ios::binary);
+    if (!out) {
+        throw runtime_error("vg::algorithms::coverage_depth: Unable to open " + filename + " for writing");
+    }
+    out.write(BINNED_DEPTH_INDEX_MAGIC, sizeof(BINNED_DEPTH_INDEX_MAGIC));
+    write_binary(out, (uint64_t)params.min_bin_size);
+    write_binary(out, (uint64_t)params.max_bin_size);
+    write_binary(out, params.exp_growth_factor);
+    write_binary(out, (uint64_t)params.min_coverage);
+    write_binary(out, (uint8_t)params.include_deletions);
+    write_binary(out, (uint8_t)params.std_err);
+    write_binary(out, fingerprint.size);
+    write_binary(out, fingerprint.checksum);
+    
+    write_binary(out, (uint64_t)depth_index.size());
+    for (auto& path_scales : depth_index) {
+        write_binary(out, (uint64_t)path_scales.first.size());
+        out.write(path_scales.first.data(), path_scales.first.size());
+        write_binary(out, (uint64_t)path_scales.second.size());
+        for (auto& scale_bins : path_scales.second) {
+            write_binary(out, (uint64_t)scale_bins.first);
+            write_binary(out, (uint64_t)scale_bins.second.size());
+            for (auto& bin : scale_bins.second) {
+                write_binary(out, (uint64_t)bin.first);
+                write_binary(out, bin.second.first);
+                write_binary(out, bin.second.second);
+            }
+        }
+    }
+    if (!out) {
+        throw runtime_error("vg::algorithms::coverage_depth: Error writing " + filename);
+    }
+}
+
+bool load_binned_depth_index(const string& filename, const BinnedDepthIndexParams& params,
+                             const PackedCoverageFingerprint& fingerprint,
+                             const vector<string>& path_names, BinnedDepthIndex& depth_index) {
+    depth_index.clear();
+    ifstream in(filename, ios::binary);
+    if (!in) {
+        throw runtime_error("vg::algorithms::coverage_depth: Unable to open " + filename);
+    }
+    char magic[sizeof(BINNED_DEPTH_INDEX_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (!in || !equal(magic, magic + sizeof(magic), BINNED_DEPTH_INDEX_MAGIC)) {
+        throw runtime_error("vg::algorithms::coverage_depth: " + filename + " is not a binned depth index");
+    }
+    
+    BinnedDepthIndexParams file_params;
+    uint64_t value;
+    uint8_t flag;
+    read_binary(in, value);
+    file_params.min_bin_size = value;
+    read_binary(in, value);
+    file_params.max_bin_size = value;
+    read_binary(in, file_params.exp_growth_factor);
+    read_binary(in, value);
+    file_params.min_coverage = value;
+    read_binary(in, flag);
+    file_params.include_deletions = flag;
+    read_binary(in, flag);
+    file_params.std_err = flag;
+    PackedCoverageFingerprint file_fingerprint;
+    read_binary(in, file_fingerprint.size);
+    read_binary(in, file_fingerprint.checksum);
+    if (!in) {
+        throw runtime_error("vg::algorithms::coverage_depth: Error reading " + filename);
+    }
+    if (!(file_params == params) || !(file_fingerprint == fingerprint)) {
+        return false;
+    }
+    
+    uint64_t path_count;
+    read_binary(in, path_count);
+    for (uint64_t i = 0; i < path_count && in; ++i) {
+        uint64_t name_length;
+        read_binary(in, name_length);
+        string path_name(name_length, '\0');
+        in.read(&path_name[0], name_length);
+        auto& scaled_depth_map = depth_index[path_name];
+        uint64_t scale_count;
+        read_binary(in, scale_count);
+        for (uint64_t j = 0; j < scale_count && in; ++j) {
+            uint64_t bin_size, bin_count;
+            read_binary(in, bin_size);
+            read_binary(in, bin_count);
+            auto& depth_map = scaled_depth_map[bin_size];
+            for (uint64_t k = 0; k < bin_count && in; ++k) {
+                uint64_t bin_start;
+                pair<float, float> depth;
+                read_binary(in, bin_start);
+                read_binary(in, depth.first);
+                read_binary(in, depth.second);
+                // bins are written in order
+                depth_map.emplace_hint(depth_map.end(), bin_start, depth);
+            }
+        }
+    }
+    if (!in) {
+        throw runtime_error("vg::algorithms::coverage_depth: Error reading " + filename);
+    }
+    
+    for (const string& path_name : path_names) {
+        if (!depth_index.count(path_name)) {
+            depth_index.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
 // draw (roughly) max_nodes nodes from the graph using the random seed
 static unordered_map<nid_t, size_t> sample_nodes(const HandleGraph& graph, size_t max_nodes, size_t random_seed) {
     default_random_engine generator(random_seed);
@@ -279,6 +441,118 @@ pair<double, double> sample_mapping_depth(const HandleGraph& graph, const string
 
 
 
+// are the confidence intervals on the mean and variance from count samples within precision of the estimates?
+// we use normal approximations for the standard errors of both
+static bool depth_sample_converged(size_t count, double mean, double variance, double precision, double z_score) {
+    if (count < 2 || mean <= 0.) {
+        return false;
+    }
+    double mean_half_width = z_score * sqrt(variance / count);
+    double variance_half_width = z_score * variance * sqrt(2. / (count - 1));
+    return mean_half_width <= precision * mean && variance_half_width <= precision * variance;
+}
+
+pair<double, double> sample_mapping_depth(const HandleGraph& graph, const string& gam_filename, const GAMIndex& gam_index,
+                                          size_t max_nodes, size_t random_seed, size_t min_coverage, size_t min_mapq,
+                                          double precision, double z_score, size_t min_nodes) {
+
+    // every thread seeks through its own stream
+    size_t thread_count = get_thread_count();
+    list<ifstream> gam_streams;
+    vector<GAMIndex::cursor_t> cursors;
+    cursors.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        gam_streams.emplace_back(gam_filename);
+        if (!gam_streams.back()) {
+            throw runtime_error("vg::algorithms::coverage_depth: Unable to open GAM file " + gam_filename);
+        }
+        cursors.emplace_back(gam_streams.back());
+    }
+
+    // draw nodes without replacement.  if we'd use most of the graph anyway, just shuffle it, otherwise
+    // draw IDs from the ID range so we never need to store the whole node set
+    default_random_engine generator(random_seed);
+    size_t node_count = graph.get_node_count();
+    vector<nid_t> shuffled_ids;
+    unordered_set<nid_t> drawn_ids;
+    bool draw_from_range = max_nodes < node_count / 2;
+    if (!draw_from_range) {
+        shuffled_ids.reserve(node_count);
+        graph.for_each_handle([&](handle_t handle) {
+                shuffled_ids.push_back(graph.get_id(handle));
+            });
+        shuffle(shuffled_ids.begin(), shuffled_ids.end(), generator);
+    }
+    uniform_int_distribution<nid_t> id_distribution(graph.min_node_id(), graph.max_node_id());
+    size_t examined = 0;
+    auto next_node = [&](nid_t& node_id) {
+        if (examined >= max_nodes || examined >= node_count) {
+            return false;
+        }
+        if (draw_from_range) {
+            do {
+                node_id = id_distribution(generator);
+            } while (!graph.has_node(node_id) || !drawn_ids.insert(node_id).second);
+        } else {
+            node_id = shuffled_ids[examined];
+        }
+        ++examined;
+        return true;
+    };
+
+    // look up nodes a batch at a time, then fold them into the estimate in the order they were drawn
+    // so that the result does not depend on the thread count
+    size_t batch_size = thread_count * 16;
+    vector<nid_t> batch;
+    vector<size_t> batch_coverage;
+    size_t count = 0;
+    double mean = 0.;
+    double M2 = 0.;
+    while (true) {
+        batch.clear();
+        nid_t node_id;
+        while (batch.size() < batch_size && next_node(node_id)) {
+            batch.push_back(node_id);
+        }
+        if (batch.empty()) {
+            break;
+        }
+        batch_coverage.assign(batch.size(), 0);
+
+#pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i = 0; i < batch.size(); ++i) {
+            nid_t batch_id = batch[i];
+            size_t& coverage = batch_coverage[i];
+            gam_index.find(cursors[omp_get_thread_num()], batch_id, [&](const Alignment& aln) {
+                    if (aln.mapping_quality() >= min_mapq) {
+                        const Path& path = aln.path();
+                        for (int j = 0; j < path.mapping_size(); ++j) {
+                            if (path.mapping(j).position().node_id() == batch_id) {
+                                coverage += mapping_from_length(path.mapping(j));
+                            }
+                        }
+                    }
+                });
+        }
+
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (batch_coverage[i] >= min_coverage) {
+                double node_len = graph.get_length(graph.get_handle(batch[i]));
+                wellford_update(count, mean, M2, (double)batch_coverage[i] / node_len);
+            }
+        }
+
+        if (precision > 0. && count >= min_nodes) {
+            pair<double, double> mean_var = wellford_mean_var(count, mean, M2);
+            if (depth_sample_converged(count, mean_var.first, mean_var.second, precision, z_score)) {
+                break;
+            }
+        }
+    }
+
+    return wellford_mean_var(count, mean, M2);
+}
+
 pair<double, double> sample_gam_depth(const HandleGraph& graph, const vector<Alignment>& alignments, size_t max_nodes, size_t random_seed, size_t min_coverage, size_t min_mapq) {
     // one node counter per thread
     vector<unordered_map<nid_t, size_t>> node_coverages(get_thread_count(), sample_nodes(graph, max_nodes, random_seed));
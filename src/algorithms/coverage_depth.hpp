@@ -11,6 +11,7 @@
 #include "handle.hpp"
 #include "statistics.hpp"
 #include "packer.hpp"
+#include "stream_index.hpp"
 
 namespace vg {
 namespace algorithms {
@@ -53,6 +54,47 @@ BinnedDepthIndex binned_packed_depth_index(const Packer& packer,
 /// Query index created above
 pair<float, float> get_depth_from_index(const BinnedDepthIndex& depth_index, const string& path_name, size_t start_offset, size_t end_offset);
 
+/// The parameters to binned_packed_depth_index(), so a saved index can be checked against them.
+/// Defaults are the ones vg call uses.
+struct BinnedDepthIndexParams {
+    size_t min_bin_size = 50;
+    size_t max_bin_size = 50000000;
+    double exp_growth_factor = 1.5;
+    size_t min_coverage = 0;
+    bool include_deletions = true;
+    bool std_err = true;
+    
+    bool operator==(const BinnedDepthIndexParams& other) const;
+};
+
+/// Build a binned depth index with the given parameters
+BinnedDepthIndex binned_packed_depth_index(const Packer& packer, const vector<string>& path_names,
+                                           const BinnedDepthIndexParams& params);
+
+/// Identifies the base coverage in a pack, so a saved index can be checked
+/// against the pack it is used with.
+struct PackedCoverageFingerprint {
+    uint64_t size = 0;
+    uint64_t checksum = 0;
+    
+    bool operator==(const PackedCoverageFingerprint& other) const;
+};
+
+/// Compute the fingerprint of the base coverage in a pack
+PackedCoverageFingerprint packed_coverage_fingerprint(const Packer& packer);
+
+/// Write a binned depth index, the parameters it was built with, and the fingerprint of the pack it
+/// was built from to a file
+void save_binned_depth_index(const BinnedDepthIndex& depth_index, const BinnedDepthIndexParams& params,
+                             const PackedCoverageFingerprint& fingerprint, const string& filename);
+
+/// Load a binned depth index written by save_binned_depth_index().  Returns false, leaving
+/// the index empty, if it was built with different parameters, from a different pack, or lacks
+/// any of the given paths. Throws runtime_error if the file can't be read.
+bool load_binned_depth_index(const string& filename, const BinnedDepthIndexParams& params,
+                             const PackedCoverageFingerprint& fingerprint,
+                             const vector<string>& path_names, BinnedDepthIndex& depth_index);
+
 /// Return the mean and variance of coverage of randomly sampled nodes from a mappings file
 /// Nodes with less than min_coverage are ignored
 /// The input_filename can be - for stdin
@@ -64,6 +106,15 @@ pair<double, double> sample_mapping_depth(const HandleGraph& graph, const string
 /// As above, but read a vector instead of a stream
 pair<double, double> sample_mapping_depth(const HandleGraph& graph, const vector<Alignment>& alignments, size_t max_nodes, size_t random_seed, size_t min_coverage, size_t min_mapq);
 
+/// As above, but instead of scanning the whole file, seek to the alignments on randomly chosen nodes
+/// in a sorted GAM using its index, one node at a time.  Sampling stops once max_nodes nodes have been
+/// examined, or once (after at least min_nodes nodes) the confidence intervals at the given z-score on both the
+/// mean and the variance are within precision (as a fraction) of the estimates.  Give a precision of 0 to always
+/// sample max_nodes nodes.
+pair<double, double> sample_mapping_depth(const HandleGraph& graph, const string& gam_filename, const GAMIndex& gam_index,
+                                          size_t max_nodes, size_t random_seed, size_t min_coverage, size_t min_mapq,
+                                          double precision, double z_score = 1.96, size_t min_nodes = 100);
+
 }
 }
 
@@ -1,4 +1,16 @@
 #include "gfa_to_handle.hpp"
+#include "../utility.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace vg {
 namespace algorithms {
@@ -15,11 +27,15 @@ nid_t parse_gfa_sequence_id(const string& str) {
 }
 
 
-void validate_gfa_edge(const gfak::edge_elem& e) {
-    string not_blunt = ("error:[gfa_to_handle_graph] Can only load blunt-ended GFAs. "
+string gfa_not_blunt_message() {
+    return ("error:[gfa_to_handle_graph] Can only load blunt-ended GFAs. "
         "Try \"bluntifying\" your graph with a tool like <https://github.com/hnikaein/stark>, or "
         "transitively merge overlaps with a pipeline of <https://github.com/ekg/gimbricate> and "
         "<https://github.com/ekg/seqwish>.");
+}
+
+void validate_gfa_edge(const gfak::edge_elem& e) {
+    string not_blunt = gfa_not_blunt_message();
     if (e.source_begin != e.source_end || e.sink_begin != 0 || e.sink_end != 0) {
         throw GFAFormatError(not_blunt + " Found edge with an overlay: " + e.source_name + "[" + to_string(e.source_begin) + ":" + to_string(e.source_end) + "] -> " + e.sink_name + "[" + to_string(e.sink_begin) + ":" + to_string(e.sink_end) + "]");
     }
@@ -66,188 +82,553 @@ void gfa_to_handle_graph_in_memory(istream& in, MutableHandleGraph* graph,
     }
 }
 
-void gfa_to_handle_graph_on_disk(const string& filename, MutableHandleGraph* graph,
-                                 bool try_id_increment_hint, gfak::GFAKluge& gg) {
-    
-    // adapted from
-    // https://github.com/vgteam/odgi/blob/master/src/gfa_to_handle.cpp
+/// A GFA file on disk, memory-mapped read-only so that it can be parsed in
+/// parallel without copying it. If the file is not a regular file (e.g. a
+/// pipe), nothing is mapped and is_mapped() is false.
+class MappedGFAFile {
+public:
+    MappedGFAFile(const string& filename) {
+        fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::ios_base::failure("error:[gfa_to_handle_graph] Couldn't open file " + filename);
+        }
+        struct stat file_stats;
+        if (fstat(fd, &file_stats) != 0) {
+            close(fd);
+            throw std::ios_base::failure("error:[gfa_to_handle_graph] Couldn't stat file " + filename);
+        }
+        if (!S_ISREG(file_stats.st_mode)) {
+            // Leave it unmapped and let the caller stream it instead
+            return;
+        }
+        regular = true;
+        length = file_stats.st_size;
+        if (length == 0) {
+            // Can't map an empty file, but there's nothing to parse either
+            return;
+        }
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            throw std::ios_base::failure("error:[gfa_to_handle_graph] Couldn't memory-map file " + filename);
+        }
+        data = (const char*) mapped;
+        // Each chunk is read front to back
+        madvise(mapped, length, MADV_SEQUENTIAL);
+    }
     
-    if (try_id_increment_hint) {
-        
-        // find the minimum ID
-        nid_t min_id = numeric_limits<nid_t>::max();
-        gg.for_each_sequence_line_in_file(filename.c_str(), [&](gfak::sequence_elem s) {
-            min_id = std::min(min_id, parse_gfa_sequence_id(s.name));
-        });
-        
-        if (min_id != numeric_limits<nid_t>::max()) {
-            // we found the min, set it as the increment
-            graph->set_id_increment(min_id);
+    ~MappedGFAFile() {
+        if (data) {
+            munmap((void*) data, length);
+        }
+        if (fd >= 0) {
+            close(fd);
         }
     }
     
-    // add in all nodes
-    gg.for_each_sequence_line_in_file(filename.c_str(), [&](gfak::sequence_elem s) {
-        
-        graph->create_handle(s.sequence, parse_gfa_sequence_id(s.name));
-        
-    });
+    MappedGFAFile(const MappedGFAFile& other) = delete;
+    MappedGFAFile& operator=(const MappedGFAFile& other) = delete;
     
-    // add in all edges
-    gg.for_each_edge_line_in_file(filename.c_str(), [&](gfak::edge_elem e) {
-        validate_gfa_edge(e);
-        handle_t a = graph->get_handle(parse_gfa_sequence_id(e.source_name), !e.source_orientation_forward);
-        handle_t b = graph->get_handle(parse_gfa_sequence_id(e.sink_name), !e.sink_orientation_forward);
-        graph->create_edge(a, b);
-    });
+    /// Is this a regular file whose contents are available through begin() and end()?
+    bool is_mapped() const {
+        return regular;
+    }
+    
+    const char* begin() const {
+        return data;
+    }
+    
+    const char* end() const {
+        return data + length;
+    }
+    
+    size_t size() const {
+        return length;
+    }
+    
+private:
+    int fd = -1;
+    bool regular = false;
+    const char* data = nullptr;
+    size_t length = 0;
+};
+
+/// A node from an S line, pointing into the mapped file for its sequence.
+struct GFANodeRecord {
+    nid_t id;
+    const char* sequence;
+    size_t length;
+};
+
+/// An edge from an L line.
+struct GFAEdgeRecord {
+    nid_t from;
+    bool from_rev;
+    nid_t to;
+    bool to_rev;
+};
+
+/// A P line, as a [begin, end) range in the mapped file. The steps are only
+/// parsed when the path is added to the graph, so they never all have to be
+/// held in memory at once.
+struct GFAPathRecord {
+    const char* begin;
+    const char* end;
+};
+
+/// Everything parsed out of one line-aligned chunk of a GFA file, in file order.
+struct GFAChunkRecords {
+    vector<GFANodeRecord> nodes;
+    vector<GFAEdgeRecord> edges;
+    vector<GFAPathRecord> paths;
+    /// Nonempty if parsing the chunk failed.
+    string error;
+};
+
+/// Parse a GFA sequence ID out of a field without allocating, falling back on
+/// the string version to report an error.
+nid_t parse_gfa_sequence_id(const char* begin, const char* end) {
+    nid_t node_id = 0;
+    for (const char* it = begin; it != end; ++it) {
+        if (!isdigit(*it) || node_id > (numeric_limits<nid_t>::max() - 9) / 10) {
+            return parse_gfa_sequence_id(string(begin, end));
+        }
+        node_id = node_id * 10 + (*it - '0');
+    }
+    if (node_id <= 0) {
+        return parse_gfa_sequence_id(string(begin, end));
+    }
+    return node_id;
 }
 
+/// Parse an orientation field from an L or GFA 0.1 P line and return true if it is reverse.
+bool parse_gfa_orientation(const char* begin, const char* end) {
+    if (end - begin == 1 && (*begin == '+' || *begin == '-')) {
+        return *begin == '-';
+    }
+    throw GFAFormatError("error:[gfa_to_handle_graph] Could not parse orientation '" + string(begin, end) + "'. GFA orientations must be + or -.");
+}
 
-/// Parse nodes and edges and load them into the given GFAKluge.
-/// If the input is a seekable file, filename will be filled in and unseekable will be nullptr.
-/// If the input is not a seekable file, filename may be filled in, and unseekable will be set to a stream to read from.
-void gfa_to_handle_graph_load_graph(const string& filename, istream* unseekable, MutableHandleGraph* graph,
-                                    bool try_id_increment_hint, gfak::GFAKluge& gg) {
-    
-    if (graph->get_node_count() > 0) {
-        throw invalid_argument("error:[gfa_to_handle_graph] Must parse GFA into an empty graph");
+/// Split the line [begin, end) into tab-separated fields, as [begin, end) ranges.
+void split_gfa_fields(const char* begin, const char* end, vector<pair<const char*, const char*>>& fields) {
+    fields.clear();
+    const char* field_begin = begin;
+    while (true) {
+        const char* field_end = (const char*) memchr(field_begin, '\t', end - field_begin);
+        if (!field_end) {
+            fields.emplace_back(field_begin, end);
+            break;
+        }
+        fields.emplace_back(field_begin, field_end);
+        field_begin = field_end + 1;
     }
-    
-    if (!unseekable) {
-        // Do the from-disk path
-        gfa_to_handle_graph_on_disk(filename, graph, try_id_increment_hint, gg);
+}
+
+/// Count the comma-separated items in a field, treating "*" and an empty field as no items.
+size_t count_gfa_list_items(const char* begin, const char* end) {
+    if (begin == end || (end - begin == 1 && *begin == '*')) {
+        return 0;
+    }
+    return count(begin, end, ',') + 1;
+}
+
+/// Parse a P line. Fills in the path name, the rank of the step for GFA 0.1
+/// lines (or -1 for GFA 1 lines), and whether the path is circular. Then calls
+/// visit_step with the ID and orientation of each step in order. A GFA 1 path
+/// is circular if its overlaps are all blunt and there is one for every step,
+/// so that the last one joins the end of the path back to its start.
+void parse_gfa_path_line(const char* line_begin, const char* line_end,
+                         vector<pair<const char*, const char*>>& fields,
+                         string& name, int64_t& rank, bool& is_circular,
+                         const function<void(nid_t, bool)>& visit_step) {
+    split_gfa_fields(line_begin, line_end, fields);
+    if (fields.size() < 3) {
+        throw GFAFormatError("error:[gfa_to_handle_graph] Found path record with too few fields: " + string(line_begin, line_end));
+    }
+    rank = -1;
+    is_circular = false;
+    if (fields.size() >= 5 && fields[4].second - fields[4].first == 1
+        && (*fields[4].first == '+' || *fields[4].first == '-')) {
+        // A GFA 0.1 path line: segment, path name, rank, orientation
+        name = process_raw_gfa_path_name(string(fields[2].first, fields[2].second));
+        string rank_string(fields[3].first, fields[3].second);
+        bool parsed = false;
+        try {
+            parsed = parse<int64_t>(rank_string, rank);
+        } catch (exception& e) {
+            // Not a number at all
+        }
+        if (!parsed || rank < 0) {
+            throw GFAFormatError("error:[gfa_to_handle_graph] Could not parse path rank '" + rank_string + "' in path " + name);
+        }
+        visit_step(parse_gfa_sequence_id(fields[1].first, fields[1].second),
+                   parse_gfa_orientation(fields[4].first, fields[4].second));
     } else {
-        // Do the path for streams
-        
-        if (try_id_increment_hint) {
-            // The ID increment hint can't be done.
-            cerr << "warning:[gfa_to_handle_graph] Skipping node ID increment hint because input stream for GFA does not support seeking. "
-                 << "If performance suffers, consider using an alternate graph implementation or reading GFA from hard disk." << endl;
+        // A GFA 1 path line: path name, comma-separated oriented segments, overlaps
+        name = process_raw_gfa_path_name(string(fields[1].first, fields[1].second));
+        const char* step_begin = fields[2].first;
+        const char* steps_end = fields[2].second;
+        if (fields.size() >= 4) {
+            size_t num_steps = count_gfa_list_items(step_begin, steps_end);
+            const char* overlap_begin = fields[3].first;
+            const char* overlaps_end = fields[3].second;
+            if (num_steps > 0 && count_gfa_list_items(overlap_begin, overlaps_end) == num_steps) {
+                is_circular = true;
+                while (overlap_begin < overlaps_end) {
+                    const char* overlap_end = (const char*) memchr(overlap_begin, ',', overlaps_end - overlap_begin);
+                    if (!overlap_end) {
+                        overlap_end = overlaps_end;
+                    }
+                    if (!(overlap_end - overlap_begin == 2 && overlap_begin[0] == '0' && overlap_begin[1] == 'M')
+                        && !(overlap_end - overlap_begin == 1 && overlap_begin[0] == '*')) {
+                        is_circular = false;
+                        break;
+                    }
+                    overlap_begin = overlap_end + 1;
+                }
+            }
+        }
+        if (steps_end - step_begin == 1 && *step_begin == '*') {
+            // Empty path
+            step_begin = steps_end;
+        }
+        while (step_begin < steps_end) {
+            const char* step_end = (const char*) memchr(step_begin, ',', steps_end - step_begin);
+            if (!step_end) {
+                step_end = steps_end;
+            }
+            if (step_end - step_begin < 2) {
+                throw GFAFormatError("error:[gfa_to_handle_graph] Could not parse path step '" + string(step_begin, step_end) + "' in path " + name);
+            }
+            visit_step(parse_gfa_sequence_id(step_begin, step_end - 1),
+                       parse_gfa_orientation(step_end - 1, step_end));
+            step_begin = step_end + 1;
         }
-        
-        gfa_to_handle_graph_in_memory(*unseekable, graph, gg);
     }
 }
 
-/// After the given GFAKluge has been populated with nodes and edges, load path information.
-/// If the input is a seekable file, filename will be filled in and unseekable will be nullptr.
-/// If the input is not a seekable file, filename may be filled in, and unseekable will be set to a stream to read from.
-void gfa_to_handle_graph_add_paths(const string& filename, istream* unseekable, MutablePathHandleGraph* graph,
-                                   gfak::GFAKluge& gg) {
-                                   
-                                   
-    if (!unseekable) {
-        // Input is from a seekable file on disk.
+/// Parse all the S, L, and P lines that start in [begin, end), which must
+/// itself start at the beginning of a line. Other record types are skipped.
+void parse_gfa_chunk(const char* begin, const char* end, GFAChunkRecords& records) {
+    
+    // Tab-separated fields of the current line, as [begin, end) ranges
+    vector<pair<const char*, const char*>> fields;
+    
+    const char* line_begin = begin;
+    while (line_begin < end) {
+        // The last line may run past the chunk end; that's fine since it
+        // started in this chunk.
+        const char* line_end = (const char*) memchr(line_begin, '\n', end - line_begin);
+        if (!line_end) {
+            line_end = end;
+        }
+        const char* next_line = line_end + 1;
+        if (line_end > line_begin && *(line_end - 1) == '\r') {
+            --line_end;
+        }
         
-        // add in all paths
-        gg.for_each_path_element_in_file(filename.c_str(), [&](const string& path_name_raw,
-                                                               const string& node_id,
-                                                               bool is_rev,
-                                                               const string& cigar,
-                                                               bool is_empty,
-                                                               bool is_circular) {
-            // remove white space in path name
-            // TODO: why?
-            string path_name = process_raw_gfa_path_name(path_name_raw);
+        char record_type = line_begin < line_end ? *line_begin : '\0';
+        if (record_type == 'P') {
+            // Paths are parsed as they are added to the graph
+            records.paths.push_back({line_begin, line_end});
+        } else if (record_type == 'S' || record_type == 'L') {
+            
+            split_gfa_fields(line_begin, line_end, fields);
             
-            // get either the existing path handle or make a new one
-            path_handle_t path;
-            if (!graph->has_path(path_name)) {
-                path = graph->create_path_handle(path_name, is_circular);
+            if (record_type == 'S') {
+                if (fields.size() < 3) {
+                    throw GFAFormatError("error:[gfa_to_handle_graph] Found sequence record with too few fields: " + string(line_begin, line_end));
+                }
+                records.nodes.push_back({parse_gfa_sequence_id(fields[1].first, fields[1].second),
+                                         fields[2].first, (size_t) (fields[2].second - fields[2].first)});
             } else {
-                path = graph->get_path_handle(path_name);
+                if (fields.size() < 5) {
+                    throw GFAFormatError("error:[gfa_to_handle_graph] Found edge record with too few fields: " + string(line_begin, line_end));
+                }
+                if (fields[1].first == fields[1].second) {
+                    throw GFAFormatError("error:[gfa_to_handle_graph] Found edge record with missing source name");
+                }
+                if (fields[3].first == fields[3].second) {
+                    throw GFAFormatError("error:[gfa_to_handle_graph] Found edge record with missing sink name");
+                }
+                if (fields.size() > 5) {
+                    string overlap(fields[5].first, fields[5].second);
+                    if (!(overlap == "0M" || overlap == "*" || overlap.empty())) {
+                        throw GFAFormatError(gfa_not_blunt_message() + " Found edge with a non-null alignment '" + overlap + "'.");
+                    }
+                }
+                records.edges.push_back({parse_gfa_sequence_id(fields[1].first, fields[1].second),
+                                         parse_gfa_orientation(fields[2].first, fields[2].second),
+                                         parse_gfa_sequence_id(fields[3].first, fields[3].second),
+                                         parse_gfa_orientation(fields[4].first, fields[4].second)});
             }
-            
-            // add the step
-            handle_t step = graph->get_handle(parse_gfa_sequence_id(node_id), is_rev);
-            graph->append_step(path, step);
-        });
-    } else {
+        }
+        
+        line_begin = next_line;
+    }
+}
+
+/// Load a GFA file from disk by memory-mapping it, parsing line-aligned chunks
+/// of it in parallel, and then inserting the parsed records into the graph in
+/// file order. Paths are added only if path_graph is not null, in which case it
+/// must be the same object as graph.
+///
+/// Returns false without modifying the graph if the file is not a regular
+/// file, so the caller can stream it instead.
+bool gfa_to_handle_graph_mapped(const string& filename, MutableHandleGraph* graph,
+                                MutablePathHandleGraph* path_graph,
+                                bool try_id_increment_hint, bool show_progress) {
+    
+    if (graph->get_node_count() > 0) {
+        throw invalid_argument("error:[gfa_to_handle_graph] Must parse GFA into an empty graph");
+    }
+    
+    MappedGFAFile file(filename);
+    if (!file.is_mapped()) {
+        return false;
+    }
+    
+    auto start_time = chrono::steady_clock::now();
+    
+    // Cut the file into line-aligned chunks, aiming for several per thread so
+    // the dynamic schedule can even out differences in line density.
+    size_t target_chunk_size = max<size_t>(file.size() / (get_thread_count() * 8), 1 << 20);
+    vector<const char*> chunk_starts;
+    const char* cursor = file.begin();
+    while (cursor < file.end()) {
+        chunk_starts.push_back(cursor);
+        if ((size_t) (file.end() - cursor) <= target_chunk_size) {
+            break;
+        }
+        const char* line_end = (const char*) memchr(cursor + target_chunk_size, '\n',
+                                                    file.end() - (cursor + target_chunk_size));
+        cursor = line_end ? line_end + 1 : file.end();
+    }
+    chunk_starts.push_back(file.end());
+    
+    size_t num_chunks = chunk_starts.size() - 1;
+    vector<GFAChunkRecords> chunks(num_chunks);
+    
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t i = 0; i < num_chunks; ++i) {
+        try {
+            parse_gfa_chunk(chunk_starts[i], chunk_starts[i + 1], chunks[i]);
+        } catch (GFAFormatError& e) {
+            // Can't throw out of the parallel loop
+            chunks[i].error = e.what();
+        } catch (out_of_range& e) {
+            // An ID too big to be a nid_t
+            chunks[i].error = string("error:[gfa_to_handle_graph] Sequence ID out of range: ") + e.what();
+        }
+    }
+    
+    // Report the first error in file order
+    for (auto& chunk : chunks) {
+        if (!chunk.error.empty()) {
+            throw GFAFormatError(chunk.error);
+        }
+    }
+    
+    auto parsed_time = chrono::steady_clock::now();
+    if (show_progress) {
+        double seconds = chrono::duration<double>(parsed_time - start_time).count();
+        double megabytes = file.size() / (1024.0 * 1024.0);
+        cerr << "[gfa_to_handle_graph] Parsed " << megabytes << " MiB in " << num_chunks << " chunks in "
+             << seconds << " seconds (" << megabytes / max(seconds, 1e-9) << " MiB/s)" << endl;
+    }
+    
+    if (try_id_increment_hint) {
+        // The minimum ID comes for free now that everything is parsed
+        nid_t min_id = numeric_limits<nid_t>::max();
+        for (auto& chunk : chunks) {
+            for (auto& node : chunk.nodes) {
+                min_id = std::min(min_id, node.id);
+            }
+        }
+        if (min_id != numeric_limits<nid_t>::max()) {
+            graph->set_id_increment(min_id);
+        }
+    }
+    
+    // add in all nodes
+    string sequence;
+    for (auto& chunk : chunks) {
+        for (auto& node : chunk.nodes) {
+            sequence.assign(node.sequence, node.length);
+            graph->create_handle(sequence, node.id);
+        }
+        chunk.nodes = vector<GFANodeRecord>();
+    }
+    
+    // add in all edges
+    for (auto& chunk : chunks) {
+        for (auto& edge : chunk.edges) {
+            // note: we're counting on implementations de-duplicating edges
+            graph->create_edge(graph->get_handle(edge.from, edge.from_rev),
+                               graph->get_handle(edge.to, edge.to_rev));
+        }
+        chunk.edges = vector<GFAEdgeRecord>();
+    }
+    
+    if (path_graph) {
+        // GFA 0.1 steps, by path, to be put in rank order once all are seen
+        unordered_map<path_handle_t, vector<pair<int64_t, handle_t>>> ranked_steps;
         
-        // gg will have parsed the GFA file in the non-path part of the algorithm
-        // No reading to do.
+        // add in all paths, parsing each one as we go
+        vector<pair<const char*, const char*>> fields;
+        string name;
+        int64_t rank;
+        bool is_circular;
+        for (auto& chunk : chunks) {
+            for (auto& record : chunk.paths) {
+                // The name and circularity are known before the first step
+                bool have_path = false;
+                path_handle_t path;
+                auto get_path = [&]() {
+                    if (!have_path) {
+                        // get either the existing path handle or make a new one
+                        if (!path_graph->has_path(name)) {
+                            path = path_graph->create_path_handle(name, is_circular);
+                        } else {
+                            path = path_graph->get_path_handle(name);
+                        }
+                        have_path = true;
+                    }
+                    return path;
+                };
+                try {
+                    parse_gfa_path_line(record.begin, record.end, fields, name, rank, is_circular,
+                                        [&](nid_t node_id, bool is_rev) {
+                        handle_t step = path_graph->get_handle(node_id, is_rev);
+                        if (rank < 0) {
+                            path_graph->append_step(get_path(), step);
+                        } else {
+                            ranked_steps[get_path()].emplace_back(rank, step);
+                        }
+                    });
+                } catch (out_of_range& e) {
+                    // An ID too big to be a nid_t
+                    throw GFAFormatError(string("error:[gfa_to_handle_graph] Sequence ID out of range: ") + e.what());
+                }
+                // Empty paths still get made
+                get_path();
+            }
+            chunk.paths = vector<GFAPathRecord>();
+        }
         
-        // create paths
-        for (const auto& path_record : gg.get_name_to_path()) {
-            
-            // process this to match the disk backed implementation
-            // TODO: why?
-            string path_name = process_raw_gfa_path_name(path_record.first);
-            path_handle_t path = graph->create_path_handle(path_name);
-            
-            for (size_t i = 0; i < path_record.second.segment_names.size(); ++i) {
-                handle_t step = graph->get_handle(parse_gfa_sequence_id(path_record.second.segment_names.at(i)),
-                                                  !path_record.second.orientations.at(i));
-                graph->append_step(path, step);
+        for (auto& path_steps : ranked_steps) {
+            stable_sort(path_steps.second.begin(), path_steps.second.end(),
+                        [](const pair<int64_t, handle_t>& a, const pair<int64_t, handle_t>& b) {
+                return a.first < b.first;
+            });
+            for (auto& step : path_steps.second) {
+                path_graph->append_step(path_steps.first, step.second);
             }
         }
     }
     
+    if (show_progress) {
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - parsed_time).count();
+        cerr << "[gfa_to_handle_graph] Loaded " << graph->get_node_count() << " nodes into graph in "
+             << seconds << " seconds" << endl;
+    }
     
+    return true;
 }
 
-void gfa_to_handle_graph(const string& filename, MutableHandleGraph* graph,
-                         bool try_from_disk, bool try_id_increment_hint) {
-
-    // What stream should we read from (isntead of opening the file), if any?
-    istream* unseekable = nullptr;
+/// Parse nodes and edges from a stream and load them into the given GFAKluge and graph.
+void gfa_to_handle_graph_load_graph(istream& in, MutableHandleGraph* graph,
+                                    bool try_id_increment_hint, gfak::GFAKluge& gg) {
     
-    // If we open a file, it will live here.
-    unique_ptr<ifstream> opened;
+    if (graph->get_node_count() > 0) {
+        throw invalid_argument("error:[gfa_to_handle_graph] Must parse GFA into an empty graph");
+    }
     
-    if (filename == "-") {
-        // Read from standard input
-        unseekable = &cin;
-    } else if (!try_from_disk) {
-        // The file may be seekable actually, but we don't want to use the
-        // seekable-file codepath for some reason.
-        opened = make_unique<ifstream>(filename);
-        if (!opened) {
-            throw std::ios_base::failure("error:[gfa_to_handle_graph] Couldn't open file " + filename);
-        }
-        unseekable = opened.get();
+    if (try_id_increment_hint) {
+        // The ID increment hint can't be done.
+        cerr << "warning:[gfa_to_handle_graph] Skipping node ID increment hint because input stream for GFA does not support seeking. "
+             << "If performance suffers, consider using an alternate graph implementation or reading GFA from hard disk." << endl;
     }
     
-    gfak::GFAKluge gg;
-    gfa_to_handle_graph_load_graph(filename, unseekable, graph, try_id_increment_hint, gg);
+    gfa_to_handle_graph_in_memory(in, graph, gg);
 }
 
+/// After the given GFAKluge has been populated with nodes and edges from a stream, load path information.
+void gfa_to_handle_graph_add_paths(MutablePathHandleGraph* graph, gfak::GFAKluge& gg) {
+    
+    // gg will have parsed the GFA file in the non-path part of the algorithm
+    // No reading to do.
+    
+    // create paths
+    for (const auto& path_record : gg.get_name_to_path()) {
+        
+        // process this to match the disk backed implementation
+        // TODO: why?
+        string path_name = process_raw_gfa_path_name(path_record.first);
+        path_handle_t path = graph->create_path_handle(path_name);
+        
+        for (size_t i = 0; i < path_record.second.segment_names.size(); ++i) {
+            handle_t step = graph->get_handle(parse_gfa_sequence_id(path_record.second.segment_names.at(i)),
+                                              !path_record.second.orientations.at(i));
+            graph->append_step(path, step);
+        }
+    }
+}
 
-void gfa_to_path_handle_graph(const string& filename, MutablePathMutableHandleGraph* graph,
-                              bool try_from_disk, bool try_id_increment_hint) {
+/// Load a GFA file into a graph, adding paths if path_graph is not null. The
+/// file is parsed in parallel straight from disk if possible, and otherwise
+/// streamed through GFAKluge.
+void gfa_to_handle_graph_load(const string& filename, MutableHandleGraph* graph,
+                              MutablePathHandleGraph* path_graph, bool try_from_disk,
+                              bool try_id_increment_hint, bool show_progress) {
     
+    if (filename != "-" && try_from_disk) {
+        // Do the from-disk path
+        if (gfa_to_handle_graph_mapped(filename, graph, path_graph, try_id_increment_hint, show_progress)) {
+            return;
+        }
+        // Otherwise this isn't a regular file and we have to stream it
+    }
     
-    // What stream should we read from (isntead of opening the file), if any?
-    istream* unseekable = nullptr;
+    // What stream should we read from (isntead of opening the file)?
+    istream* in = &cin;
     
     // If we open a file, it will live here.
     unique_ptr<ifstream> opened;
     
-    if (filename == "-") {
-        // Read from standard input
-        unseekable = &cin;
-    } else if (!try_from_disk) {
-        // The file may be seekable actually, but we don't want to use the
-        // seekable-file codepath for some reason.
+    if (filename != "-") {
         opened = make_unique<ifstream>(filename);
-        if (!opened) {
+        if (!*opened) {
             throw std::ios_base::failure("error:[gfa_to_handle_graph] Couldn't open file " + filename);
         }
-        unseekable = opened.get();
+        in = opened.get();
     }
     
     gfak::GFAKluge gg;
-    gfa_to_handle_graph_load_graph(filename, unseekable, graph, try_id_increment_hint, gg);
-    
-    // TODO: Deduplicate everything other than this line somehow.
-    gfa_to_handle_graph_add_paths(filename, unseekable, graph, gg);
+    gfa_to_handle_graph_load_graph(*in, graph, try_id_increment_hint, gg);
+    if (path_graph) {
+        gfa_to_handle_graph_add_paths(path_graph, gg);
+    }
+}
+
+void gfa_to_handle_graph(const string& filename, MutableHandleGraph* graph,
+                         bool try_from_disk, bool try_id_increment_hint,
+                         bool show_progress) {
+    gfa_to_handle_graph_load(filename, graph, nullptr, try_from_disk, try_id_increment_hint, show_progress);
+}
+
+
+void gfa_to_path_handle_graph(const string& filename, MutablePathMutableHandleGraph* graph,
+                              bool try_from_disk, bool try_id_increment_hint,
+                              bool show_progress) {
+    gfa_to_handle_graph_load(filename, graph, graph, try_from_disk, try_id_increment_hint, show_progress);
 }
 
 void gfa_to_path_handle_graph_in_memory(istream& in,
                                         MutablePathMutableHandleGraph* graph) {
     gfak::GFAKluge gg;
-    gfa_to_handle_graph_load_graph("", &in, graph, false, gg);
-    gfa_to_handle_graph_add_paths("", &in, graph, gg);
+    gfa_to_handle_graph_load_graph(in, graph, false, gg);
+    gfa_to_handle_graph_add_paths(graph, gg);
     
 }
 
@@ -26,24 +26,29 @@ struct GFAFormatError : std::runtime_error {
 /// Read a GFA file for a blunt-ended graph into a HandleGraph. Give "-" as a filename for stdin.
 ///
 /// Optionally tries read the GFA from disk without creating an in-memory representation (defaults to
-/// in-memory algorithm if reading from stdin).
+/// in-memory algorithm if reading from stdin or a pipe). The on-disk algorithm memory-maps the file and
+/// parses it in parallel using the OMP thread count.
 ///
 /// Also optionally provides a hint about the node ID range to the handle graph implementation before
 /// constructing it (defaults to no hint if reading from stdin).
 ///
+/// If show_progress is set, reports parsing throughput on stderr.
+///
 /// Throws GFAFormatError if the GFA file is not acceptable, and
 /// std::ios_base::failure if an IO operation fails. Throws invalid_argument if
 /// otherwise misused.
 void gfa_to_handle_graph(const string& filename,
                          MutableHandleGraph* graph,
                          bool try_from_disk = true,
-                         bool try_id_increment_hint = false);
+                         bool try_id_increment_hint = false,
+                         bool show_progress = false);
 
 /// Same as gfa_to_handle_graph but also adds path elements from the GFA to the graph
 void gfa_to_path_handle_graph(const string& filename,
                               MutablePathMutableHandleGraph* graph,
                               bool try_from_disk = true,
-                              bool try_id_increment_hint = false);
+                              bool try_id_increment_hint = false,
+                              bool show_progress = false);
                               
 /// Same as above but operating on a stream. Assumed to be non-seekable; all conversion happens in memory.
 /// Always streaming. Doesn't support ID increment hints.
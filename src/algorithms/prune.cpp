@@ -4,6 +4,8 @@
 #include "source_sink_overlay.hpp"
 
 #include <stack>
+#include <atomic>
+#include <algorithm>
 
 namespace vg {
 namespace algorithms {
@@ -24,25 +26,97 @@ struct walk_t {
     uint16_t length; /// how far we've been
 };
 
-constexpr size_t PRUNE_THREAD_BUFFER_SIZE = 1024 * 1024;
-
-pair_hash_set<edge_t> find_edges_to_prune(const HandleGraph& graph, size_t k, size_t edge_max) {
+/// A compact, thread-safe bit vector over the edges of a graph, addressed by
+/// the side an edge leaves from and its ordinal among that side's edges.
+/// Marking is lock-free, so all threads can write into the same structure.
+class EdgeMarks {
+public:
+    EdgeMarks(const HandleGraph& graph) : graph(graph) {
+        if (graph.get_node_count() == 0) {
+            return;
+        }
+        min_id = graph.min_node_id();
+        side_offsets.resize(2 * (graph.max_node_id() - min_id + 1) + 1, 0);
+        // Count the edges on each side in parallel. Every side belongs to
+        // exactly one node, so there are no write conflicts. Marks are
+        // numbered by follow_edges, so count with it too: some graphs (like
+        // SourceSinkOverlay) report degrees that don't match what they
+        // follow.
+        graph.for_each_handle([&](const handle_t& h) {
+            for (handle_t from : {h, graph.flip(h)}) {
+                size_t& count = side_offsets[side_of(from) + 1];
+                graph.follow_edges(from, false, [&](const handle_t& next) {
+                    count++;
+                });
+            }
+        }, true);
+        for (size_t i = 1; i < side_offsets.size(); i++) {
+            side_offsets[i] += side_offsets[i - 1];
+        }
+        words = std::vector<std::atomic<uint64_t>>((side_offsets.back() + 63) / 64);
+        for (auto& word : words) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+    
+    /// Mark the edge that is the ordinal-th edge out of the given handle
+    void mark(const handle_t& from, size_t ordinal) {
+        size_t bit = side_offsets[side_of(from)] + ordinal;
+        words[bit / 64].fetch_or(uint64_t(1) << (bit % 64), std::memory_order_relaxed);
+    }
     
-    // Each thread collects edges to be deleted into a separate buffer. When the buffer grows
-    // large enough, flush it into a shared hash set.
-    pair_hash_set<edge_t> result;
-    auto flush_buffer = [&result](pair_hash_set<edge_t>& buffer) {
-#pragma omp critical (prune_flush)
-        {
-            for (const edge_t& edge : buffer) {
-                result.insert(edge);
+    /// Collect all marked edges in canonical form, each one exactly once, in a
+    /// deterministic order.
+    std::vector<edge_t> collect() const {
+        std::vector<std::vector<edge_t>> thread_edges(get_thread_count());
+        graph.for_each_handle([&](const handle_t& h) {
+            auto& edges = thread_edges[omp_get_thread_num()];
+            for (handle_t from : {h, graph.flip(h)}) {
+                size_t first_bit = side_offsets[side_of(from)];
+                size_t ordinal = 0;
+                graph.follow_edges(from, false, [&](const handle_t& next) {
+                    size_t bit = first_bit + ordinal++;
+                    if (words[bit / 64].load(std::memory_order_relaxed) & (uint64_t(1) << (bit % 64))) {
+                        edges.push_back(graph.edge_handle(from, next));
+                    }
+                });
             }
+        }, true);
+        
+        std::vector<edge_t> result;
+        for (auto& edges : thread_edges) {
+            result.insert(result.end(), edges.begin(), edges.end());
         }
-        buffer.clear();
-    };
+        // An edge can be seen from both of its sides, or marked from both
+        std::sort(result.begin(), result.end(), [&](const edge_t& a, const edge_t& b) {
+            return std::make_pair(as_integer(a.first), as_integer(a.second)) <
+                std::make_pair(as_integer(b.first), as_integer(b.second));
+        });
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+    
+private:
+    /// Get the index of the side that edges followed off the end of the handle leave from
+    inline size_t side_of(const handle_t& h) const {
+        return 2 * (graph.get_id(h) - min_id) + (graph.get_is_reverse(h) ? 1 : 0);
+    }
+    
+    const HandleGraph& graph;
+    nid_t min_id = 0;
+    /// Index of the first bit of each side, plus a past-the-end sentinel
+    std::vector<size_t> side_offsets;
+    std::vector<std::atomic<uint64_t>> words;
+};
+
+std::vector<edge_t> find_edges_to_prune(const HandleGraph& graph, size_t k, size_t edge_max) {
+    
+    // Threads mark the edges to be deleted in a shared bit vector without
+    // locking. Once the parallel walk is done, the marks are turned back into
+    // edges in a single pass.
+    EdgeMarks marks(graph);
     
     // for each position on the forward and reverse of the graph
-    std::vector<pair_hash_set<edge_t>> buffers(get_thread_count());
     graph.for_each_handle([&](const handle_t& h) {
         // for the forward and reverse of this handle
         // walk k bases from the end, so that any kmer starting on the node will be represented in the tree we build
@@ -59,13 +133,10 @@ pair_hash_set<edge_t> find_edges_to_prune(const HandleGraph& graph, size_t k, si
                 // We are only interested in walks that did not reach length k in the initial node.
                 if (offset(end) - offset(begin) < k) {
                     size_t outdegree = graph.get_degree(handle, false);
+                    size_t ordinal = 0;
                     graph.follow_edges(handle, false, [&](const handle_t& next) {
                         if (outdegree > 1 && edge_max == 0) { // our next step takes us over the max
-                            int tid = omp_get_thread_num();
-                            buffers[tid].insert(graph.edge_handle(handle, next));
-                            if (buffers[tid].size() >= PRUNE_THREAD_BUFFER_SIZE) {
-                                flush_buffer(buffers[tid]);
-                            }
+                            marks.mark(handle, ordinal);
                         } else {
                             walk_t walk(offset(end) - offset(begin), begin, end, next, 0);
                             if (outdegree > 1) {
@@ -73,6 +144,7 @@ pair_hash_set<edge_t> find_edges_to_prune(const HandleGraph& graph, size_t k, si
                             }
                             walks.push(walk);
                         }
+                        ordinal++;
                     });
                 }
             }
@@ -94,13 +166,10 @@ pair_hash_set<edge_t> find_edges_to_prune(const HandleGraph& graph, size_t k, si
                 // Do we need to continue to the successor nodes?
                 if (walk.length < k) {
                     size_t outdegree = graph.get_degree(walk.curr, false);
+                    size_t ordinal = 0;
                     graph.follow_edges(walk.curr, false, [&](const handle_t& next) {
                         if (outdegree > 1 && edge_max == walk.forks) { // our next step takes us over the max
-                            int tid = omp_get_thread_num();
-                            buffers[tid].insert(graph.edge_handle(walk.curr, next));
-                            if (buffers[tid].size() >= PRUNE_THREAD_BUFFER_SIZE) {
-                                flush_buffer(buffers[tid]);
-                            }
+                            marks.mark(walk.curr, ordinal);
                         } else {
                             walk_t next_walk = walk;
                             next_walk.curr = next;
@@ -109,22 +178,20 @@ pair_hash_set<edge_t> find_edges_to_prune(const HandleGraph& graph, size_t k, si
                             }
                             walks.push(next_walk);
                         }
+                        ordinal++;
                     });
                 }
             }
         }
     }, true);
     
-    // Flush the buffers and return the result.
-    for (pair_hash_set<edge_t>& buffer : buffers) {
-        flush_buffer(buffer);
-    }
-    return result;
+    return marks.collect();
 }
 
 void prune_complex(DeletableHandleGraph& graph,
                    int path_length, int edge_max) {
     
+    // Deletion happens in one bulk pass after all the marking is done
     for (auto& edge : find_edges_to_prune(graph,
                                           path_length,
                                           edge_max)) {
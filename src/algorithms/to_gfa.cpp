@@ -1,37 +1,160 @@
 #include "to_gfa.hpp"
 
+#include <omp.h>
+#include <htslib/bgzf.h>
+
 namespace vg {
 namespace algorithms {
 
 using namespace std;
 
-void to_gfa(const PathHandleGraph& graph, ostream& out) {
-    graph.for_each_handle([&out,&graph](const handle_t& h) {
-            out << "S\t" << graph.get_id(h) << "\t" << graph.get_sequence(h) << std::endl;
-            graph.follow_edges(h, true, [&out,&graph,&h](const handle_t& n) {
-                    out << "L\t" << graph.get_id(h) << "\t"
-                        << (graph.get_is_reverse(h)?"-":"+")
-                        << "\t" << graph.get_id(n) << "\t"
-                        << (graph.get_is_reverse(n)?"-":"+")
-                        << "\t0M" << std::endl;
-                });
+/// How many nodes' worth of S or L lines to format into one block of output.
+static const size_t GFA_NODES_PER_BLOCK = 1024;
+
+/// The BGZF end-of-file marker: an empty BGZF block.
+static const char BGZF_EOF_MARKER[28] = {
+    '\x1f', '\x8b', '\x08', '\x04', '\x00', '\x00', '\x00', '\x00', '\x00', '\xff', '\x06', '\x00', '\x42', '\x43',
+    '\x02', '\x00', '\x1b', '\x00', '\x03', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00'
+};
+
+/// Compress the given text into a series of BGZF blocks in place.
+static void bgzip_block(string& text) {
+    string compressed;
+    vector<char> buffer(BGZF_MAX_BLOCK_SIZE);
+    for (size_t i = 0; i < text.size(); i += BGZF_BLOCK_SIZE) {
+        size_t block_length = min<size_t>(BGZF_BLOCK_SIZE, text.size() - i);
+        size_t compressed_length = buffer.size();
+        if (bgzf_compress(buffer.data(), &compressed_length, text.data() + i, block_length, -1) != 0) {
+            cerr << "error:[algorithms::to_gfa] could not compress GFA output" << endl;
+            exit(1);
+        }
+        compressed.append(buffer.data(), compressed_length);
+    }
+    text = move(compressed);
+}
+
+/// Format the given number of blocks in parallel, and write them out in
+/// order. Formats at most a few blocks per thread at a time, so that only a
+/// bounded amount of output is buffered.
+static void write_blocks_in_order(size_t num_blocks, const function<void(size_t, string&)>& format_block,
+                                  bool bgzip, ostream& out) {
+    size_t batch_size = omp_get_max_threads() * 4;
+    vector<string> blocks(batch_size);
+    for (size_t batch_start = 0; batch_start < num_blocks; batch_start += batch_size) {
+        size_t batch_end = min(num_blocks, batch_start + batch_size);
+#pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i = batch_start; i < batch_end; ++i) {
+            string& block = blocks[i - batch_start];
+            block.clear();
+            format_block(i, block);
+            if (bgzip) {
+                bgzip_block(block);
+            }
+        }
+        for (size_t i = batch_start; i < batch_end; ++i) {
+            out.write(blocks[i - batch_start].data(), blocks[i - batch_start].size());
+        }
+    }
+}
+
+/// Append an L line for the given edge, flipped if necessary so that it reads
+/// from a forward node when possible, and then from low ID to high ID.
+static void append_link(const PathHandleGraph& graph, const handle_t& from, const handle_t& to, string& block) {
+    nid_t from_id = graph.get_id(from);
+    nid_t to_id = graph.get_id(to);
+    bool from_rev = graph.get_is_reverse(from);
+    bool to_rev = graph.get_is_reverse(to);
+    if (from_rev && (to_rev || to_id < from_id)) {
+        swap(from_id, to_id);
+        swap(from_rev, to_rev);
+        from_rev = !from_rev;
+        to_rev = !to_rev;
+    }
+    block += "L\t";
+    block += to_string(from_id);
+    block += from_rev ? "\t-\t" : "\t+\t";
+    block += to_string(to_id);
+    block += to_rev ? "\t-\t0M\n" : "\t+\t0M\n";
+}
+
+void to_gfa(const PathHandleGraph& graph, ostream& out, bool bgzip) {
+
+    // Fix an order for the nodes, so the output is the same no matter how
+    // the work is divided up.
+    vector<handle_t> handles;
+    handles.reserve(graph.get_node_count());
+    graph.for_each_handle([&](const handle_t& h) {
+        handles.push_back(h);
+    });
+    size_t num_node_blocks = (handles.size() + GFA_NODES_PER_BLOCK - 1) / GFA_NODES_PER_BLOCK;
+
+    vector<path_handle_t> paths;
+    graph.for_each_path_handle([&](const path_handle_t& p) {
+        paths.push_back(p);
+    });
+
+    // header
+    write_blocks_in_order(1, [&](size_t i, string& block) {
+        block += "H\tVN:Z:1.0\n";
+    }, bgzip, out);
+
+    // S lines
+    write_blocks_in_order(num_node_blocks, [&](size_t i, string& block) {
+        size_t end = min(handles.size(), (i + 1) * GFA_NODES_PER_BLOCK);
+        for (size_t j = i * GFA_NODES_PER_BLOCK; j < end; ++j) {
+            block += "S\t";
+            block += to_string(graph.get_id(handles[j]));
+            block += '\t';
+            block += graph.get_sequence(handles[j]);
+            block += '\n';
+        }
+    }, bgzip, out);
+
+    // P lines, one path per block
+    write_blocks_in_order(paths.size(), [&](size_t i, string& block) {
+        block += "P\t";
+        block += graph.get_path_name(paths[i]);
+        block += '\t';
+        string overlaps;
+        bool first = true;
+        graph.for_each_step_in_path(paths[i], [&](const step_handle_t& step) {
+            handle_t h = graph.get_handle_of_step(step);
+            if (!first) {
+                block += ',';
+                overlaps += ',';
+            }
+            first = false;
+            block += to_string(graph.get_id(h));
+            block += graph.get_is_reverse(h) ? '-' : '+';
+            overlaps += to_string(graph.get_length(h));
+            overlaps += 'M';
         });
-    graph.for_each_path_handle([&out,&graph](const path_handle_t& p) {
-            //step_handle_t step = path_begin(p);
-            out << "P\t" << graph.get_path_name(p) << "\t";
-            graph.for_each_step_in_path(p, [&out,&graph](const step_handle_t& step) {
-                    handle_t h = graph.get_handle_of_step(step);
-                    out << graph.get_id(h) << (graph.get_is_reverse(h)?"-":"+");
-                    if (graph.has_next_step(step)) out << ",";
-                });
-            out << "\t";
-            graph.for_each_step_in_path(p, [&out,&graph](const step_handle_t& step) {
-                    out << graph.get_length(graph.get_handle_of_step(step)) << "M";
-                    if (graph.has_next_step(step)) out << ",";
+        block += '\t';
+        block += overlaps.empty() ? "*" : overlaps;
+        block += '\n';
+    }, bgzip, out);
+
+    // L lines, each written out by the node it is listed under in its
+    // canonical orientation
+    write_blocks_in_order(num_node_blocks, [&](size_t i, string& block) {
+        size_t end = min(handles.size(), (i + 1) * GFA_NODES_PER_BLOCK);
+        for (size_t j = i * GFA_NODES_PER_BLOCK; j < end; ++j) {
+            handle_t h = graph.forward(handles[j]);
+            for (handle_t side : {h, graph.flip(h)}) {
+                graph.follow_edges(side, false, [&](const handle_t& next) {
+                    edge_t canonical = graph.edge_handle(side, next);
+                    if (canonical.first == side && canonical.second == next) {
+                        append_link(graph, side, next, block);
+                    }
                 });
-            out << std::endl;
-        });
+            }
+        }
+    }, bgzip, out);
+
+    if (bgzip) {
+        out.write(BGZF_EOF_MARKER, sizeof(BGZF_EOF_MARKER));
+    }
 }
-    
+
 }
 }
@@ -10,7 +10,11 @@ namespace algorithms {
 
 using namespace std;
 
-void to_gfa(const PathHandleGraph& graph, ostream& out);
+/// Write the graph to the stream in GFA 1 format: a header, then S, P, and L
+/// lines. Records are formatted in blocks in parallel using the OMP thread
+/// count, but are always written in the same order. If bgzip is set, the
+/// output is compressed as BGZF.
+void to_gfa(const PathHandleGraph& graph, ostream& out, bool bgzip = false);
 
 }
 }
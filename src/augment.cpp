@@ -27,7 +27,8 @@ void augment(MutablePathMutableHandleGraph* graph,
              double min_mapq,
              Packer* packer,
              size_t min_bp_coverage,
-             double max_frac_n) {
+             double max_frac_n,
+             map<pos_t, id_t>* out_node_translation) {
 
     // memory-wasting hack: we need node lengths from the original graph in order to parse the GAF.  Unlesss we
     // store them, they will be lost in the 2nd pass
@@ -89,7 +90,8 @@ void augment(MutablePathMutableHandleGraph* graph,
                  min_mapq,                 
                  packer,
                  min_bp_coverage,
-                 max_frac_n);
+                 max_frac_n,
+                 out_node_translation);
 }
 
 void augment(MutablePathMutableHandleGraph* graph,
@@ -105,7 +107,8 @@ void augment(MutablePathMutableHandleGraph* graph,
              double min_mapq,
              Packer* packer,
              size_t min_bp_coverage,
-             double max_frac_n) {
+             double max_frac_n,
+             map<pos_t, id_t>* out_node_translation) {
     
     function<void(function<void(Alignment&)>, bool, bool)> iterate_gam =
         [&path_vector] (function<void(Alignment&)> aln_callback, bool second_pass, bool parallel) {
@@ -143,7 +146,8 @@ void augment(MutablePathMutableHandleGraph* graph,
                  min_mapq,
                  packer,
                  min_bp_coverage,
-                 max_frac_n);
+                 max_frac_n,
+                 out_node_translation);
 }
 
 // Check if alignment contains node that's not in the graph
@@ -179,7 +183,8 @@ void augment_impl(MutablePathMutableHandleGraph* graph,
                   double min_mapq,
                   Packer* packer,
                   size_t min_bp_coverage,
-                  double max_frac_n) {
+                  double max_frac_n,
+                  map<pos_t, id_t>* out_node_translation) {
 
     // toggle between using Packer to store breakpoints or the STL map
     bool packed_mode = min_bp_coverage > 0 || min_baseq > 0 || max_frac_n < 1.;
@@ -342,6 +347,10 @@ void augment_impl(MutablePathMutableHandleGraph* graph,
         *out_translations = make_translation(graph, node_translation, added_nodes, orig_node_sizes);
     }
 
+    if (out_node_translation != nullptr) {
+        *out_node_translation = move(node_translation);
+    }
+
     VG* vg_graph = dynamic_cast<VG*>(graph);
     
     // This code got run after augment in VG::edit, so we make sure it happens here too
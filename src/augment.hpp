@@ -43,6 +43,10 @@ using namespace std;
 /// A packer is required for all non-mapq filters
 /// If a breakpoint has less than min_bp_coverage it is not included in the graph
 /// Edits with more than max_frac_n N content will be ignored
+/// If out_node_translation is not null, it is filled in with the start
+/// position on each strand of each piece of each original node that was
+/// broken, mapped to the ID of the node holding that piece (or 0 for the
+/// end of the original node). This is much cheaper than out_translation.
 void augment(MutablePathMutableHandleGraph* graph,
              const string& gam_path,
              const string& aln_format = "GAM",
@@ -56,7 +60,8 @@ void augment(MutablePathMutableHandleGraph* graph,
              double min_mapq = 0,
              Packer* packer = nullptr,
              size_t min_bp_coverage = 0,
-             double max_frac_n = 1.);
+             double max_frac_n = 1.,
+             map<pos_t, id_t>* out_node_translation = nullptr);
 
 /// Like above, but operates on a vector of Alignments, instead of a file
 /// (Note: It is best to use file interface to stream large numbers of alignments to save memory)
@@ -73,7 +78,8 @@ void augment(MutablePathMutableHandleGraph* graph,
              double min_mapq = 0,
              Packer* packer = nullptr,
              size_t min_bp_coverage = 0,
-             double max_frac_n = 1.);
+             double max_frac_n = 1.,
+             map<pos_t, id_t>* out_node_translation = nullptr);
 
 /// Generic version used to implement the above three methods.  
 void augment_impl(MutablePathMutableHandleGraph* graph,
@@ -89,7 +95,8 @@ void augment_impl(MutablePathMutableHandleGraph* graph,
                   double min_mapq,
                   Packer* packer,
                   size_t min_bp_coverage,
-                  double max_frac_n);
+                  double max_frac_n,
+                  map<pos_t, id_t>* out_node_translation);
 
 /// Add a path to the graph.  This is like VG::extend, and expects
 /// a path with no edits, and for all the nodes and edges in the path
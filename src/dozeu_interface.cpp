@@ -155,10 +155,7 @@ pair<DozeuInterface::graph_pos_s, bool> DozeuInterface::scan_seed_position(const
         pack_qual = (const uint8_t*) (direction ? query_qual.c_str() : query_qual.c_str() + (qlen - scan_len));
     }
     
-	const dz_query_s* packed_query = (direction
-		? pack_query_reverse(pack_seq, pack_qual, full_length_bonus, scan_len)
-		: pack_query_forward(pack_seq, pack_qual, full_length_bonus, scan_len)
-	);
+	const dz_query_s* packed_query = get_packed_query(pack_seq, pack_qual, full_length_bonus, scan_len, !direction);
     
     // make a root forefront
     dz_alignment_init_s aln_init = dz_align_init(dz, max_gap_length);
@@ -304,6 +301,50 @@ size_t DozeuInterface::do_poa(const OrderedGraph& graph, const dz_query_s* packe
     return max_idx;
 }
 
+// get a query packed into query_dz, reusing one packed since query_dz was last flushed if
+// it has the same direction, full length bonus, sequence and qualities. once max_cached_queries
+// have been packed, query_dz is flushed and the cache starts over, so a returned query is only
+// valid until the next call.
+const dz_query_s* DozeuInterface::get_packed_query(const char* seq, const uint8_t* qual, int8_t full_length_bonus,
+                                                   size_t len, bool forward)
+{
+    for (size_t i = 0; i < num_cached_queries; ++i) {
+        const cached_query_s& cached = query_cache[i];
+        if (cached.forward == forward && cached.full_length_bonus == full_length_bonus
+            && cached.seq.size() == len && cached.seq.compare(0, len, seq, len) == 0
+            && (qual == nullptr
+                ? cached.qual.empty()
+                : cached.qual.size() == len && cached.qual.compare(0, len, (const char*) qual, len) == 0)) {
+            return cached.packed;
+        }
+    }
+    
+    if (num_cached_queries == max_cached_queries) {
+        // start over, reusing the arena
+        flush_queries();
+        num_cached_queries = 0;
+    }
+    if (query_cache.size() == num_cached_queries) {
+        query_cache.emplace_back();
+    }
+    
+    cached_query_s& cached = query_cache[num_cached_queries++];
+    cached.forward = forward;
+    cached.full_length_bonus = full_length_bonus;
+    cached.seq.assign(seq, len);
+    if (qual == nullptr) {
+        cached.qual.clear();
+    }
+    else {
+        cached.qual.assign((const char*) qual, len);
+    }
+    cached.packed = (forward
+        ? pack_query_forward(seq, qual, full_length_bonus, len)
+        : pack_query_reverse(seq, qual, full_length_bonus, len)
+    );
+    return cached.packed;
+}
+
 // append an edit at the end of the current mapping array, returns forwarded length on the query
 size_t DozeuInterface::push_edit(Mapping *mapping, uint8_t op, char const *alt, size_t len) const
 {
@@ -657,8 +698,8 @@ void DozeuInterface::align(Alignment& alignment, const HandleGraph& graph, const
         
         // pack query (upward)
 		const dz_query_s* packed_query_seq_up = (direction
-			? pack_query_reverse(pack_seq, pack_qual, full_length_bonus, seed_pos.query_offset)
-			: pack_query_forward(pack_seq, pack_qual, full_length_bonus, query_seq.size() - seed_pos.query_offset)
+			? get_packed_query(pack_seq, pack_qual, full_length_bonus, seed_pos.query_offset, false)
+			: get_packed_query(pack_seq, pack_qual, full_length_bonus, query_seq.size() - seed_pos.query_offset, true)
 		);
 		// upward extension
 		head_pos = calculate_max_position(ordered_graph, seed_pos,
@@ -703,8 +744,8 @@ void DozeuInterface::align_downward(Alignment& alignment, const OrderedGraph& gr
     
 	// pack query (downward)
 	const dz_query_s* packed_query_seq_dn = (left_to_right
-		? pack_query_forward(pack_seq, pack_qual, full_length_bonus, qlen - head_positions.front().query_offset)
-		: pack_query_reverse(pack_seq, pack_qual, full_length_bonus, head_positions.front().query_offset)
+		? get_packed_query(pack_seq, pack_qual, full_length_bonus, qlen - head_positions.front().query_offset, true)
+		: get_packed_query(pack_seq, pack_qual, full_length_bonus, head_positions.front().query_offset, false)
 	);
 
 	// downward extension
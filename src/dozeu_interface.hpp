@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -54,6 +55,10 @@ static constexpr uint16_t default_xdrop_max_gap_length = 40;
  * This class maintains an internal dz_s, which is *NOT THREADSAFE*,
  * and non-const during alignments. However, it may be reused for
  * subsequent alignments.
+ *
+ * Packed queries are kept in a second dz_s, which is not flushed after
+ * each alignment. Aligning the same stretch of read again, as happens when
+ * aligning a read's tails against several trees, reuses the packed query.
  */
 class DozeuInterface {
     
@@ -143,6 +148,8 @@ protected:
     
     // wrappers for dozeu functions that can be used to toggle between between quality
     // adjusted and standard alignments
+    
+    // pack queries into query_dz
     virtual dz_query_s* pack_query_forward(const char* seq, const uint8_t* qual,
                                            int8_t full_length_bonus, size_t len) = 0;
     virtual dz_query_s* pack_query_reverse(const char* seq, const uint8_t* qual,
@@ -155,6 +162,15 @@ protected:
                                          uint32_t rid, uint16_t xt) = 0;
     virtual dz_alignment_s* trace(const dz_forefront_s* forefront) = 0;
     virtual void flush() = 0;
+    // free all the packed queries in query_dz
+    virtual void flush_queries() = 0;
+    
+    /// Get the query for the len bases starting at seq (and qual, if not
+    /// null), packed to align forward or in reverse. Reuses a query packed
+    /// since query_dz was last flushed, if there is one. The returned query
+    /// is valid until the next call.
+    const dz_query_s* get_packed_query(const char* seq, const uint8_t* qual, int8_t full_length_bonus,
+                                       size_t len, bool forward);
     
     /// Given the subgraph we are aligning to, the MEM hist against it, the
     /// length of the query, and the direction we are aligning the query in
@@ -242,6 +258,29 @@ protected:
     
     /// The core dozeu class, which does the alignments
     dz_s* dz = nullptr;
+    
+    /// A second dozeu instance with the same scores, which holds the packed
+    /// queries so they can outlive the alignment they were packed for
+    dz_s* query_dz = nullptr;
+    
+    /**
+     * A query packed into query_dz, and what it was packed from.
+     */
+    struct cached_query_s {
+        bool forward;
+        int8_t full_length_bonus;
+        string seq;
+        string qual;
+        const dz_query_s* packed;
+    };
+    
+    /// How many queries to pack before flushing query_dz
+    static constexpr size_t max_cached_queries = 16;
+    
+    /// The queries packed since query_dz was last flushed are the first
+    /// num_cached_queries of these. The rest keep their string buffers.
+    vector<cached_query_s> query_cache;
+    size_t num_cached_queries = 0;
 };
 
 /*
@@ -272,6 +311,7 @@ private:
                                  uint32_t rid, uint16_t xt);
     dz_alignment_s* trace(const dz_forefront_s* forefront);
     void flush();
+    void flush_queries();
     
 public:
     
@@ -318,6 +358,7 @@ private:
                                          uint32_t rid, uint16_t xt);
     dz_alignment_s* trace(const dz_forefront_s* forefront);
     void flush();
+    void flush_queries();
     
 public:
     
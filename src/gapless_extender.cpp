@@ -2,7 +2,6 @@
 
 #include <algorithm>
 #include <cstring>
-#include <queue>
 #include <set>
 #include <stack>
 
@@ -363,29 +362,50 @@ size_t interval_length(std::pair<size_t, size_t> interval) {
     return interval.second - interval.first;
 }
 
-std::vector<handle_t> get_path(const std::vector<handle_t>& first, handle_t second) {
-    std::vector<handle_t> result;
-    result.reserve(first.size() + 1);
-    result.insert(result.end(), first.begin(), first.end());
-    result.push_back(second);
-    return result;
-}
+// The paths of all extension candidates for a seed, stored as a tree of
+// handles in a single buffer. A candidate is extended to the right before it
+// is extended to the left, so its path is a chain of left extensions
+// followed by the seed node and a chain of right extensions.
+struct PathBuffer {
+    constexpr static size_t NO_PARENT = std::numeric_limits<size_t>::max();
 
-std::vector<handle_t> get_path(handle_t first, const std::vector<handle_t>& second) {
-    std::vector<handle_t> result;
-    result.reserve(second.size() + 1);
-    result.push_back(first);
-    result.insert(result.end(), second.begin(), second.end());
-    return result;
-}
+    // (handle, index of the next handle towards the seed node)
+    std::vector<std::pair<handle_t, size_t>> nodes;
 
-std::vector<handle_t> get_path(const std::vector<handle_t>& first, gbwt::node_type second) {
-    return get_path(first, gbwtgraph::GBWTGraph::node_to_handle(second));
-}
+    void clear() { this->nodes.clear(); }
 
-std::vector<handle_t> get_path(gbwt::node_type reverse_first, const std::vector<handle_t>& second) {
-    return get_path(gbwtgraph::GBWTGraph::node_to_handle(gbwt::Node::reverse(reverse_first)), second);
-}
+    // Add a handle after the given one and return its index.
+    size_t extend(size_t parent, handle_t handle) {
+        this->nodes.emplace_back(handle, parent);
+        return this->nodes.size() - 1;
+    }
+
+    // Write the path of the candidate with the given leftmost left extension
+    // and rightmost right extension into the vector.
+    void get_path(size_t left_head, size_t right_tail, std::vector<handle_t>& path) const {
+        path.clear();
+        for (size_t i = left_head; i != NO_PARENT; i = this->nodes[i].second) {
+            path.push_back(this->nodes[i].first);
+        }
+        size_t left_length = path.size();
+        for (size_t i = right_tail; i != NO_PARENT; i = this->nodes[i].second) {
+            path.push_back(this->nodes[i].first);
+        }
+        std::reverse(path.begin() + left_length, path.end());
+    }
+};
+
+// An extension being built, with its path in a PathBuffer. Its own path and
+// mismatch vectors are left empty until it is chosen, so the candidates can
+// be created and moved around without allocating memory.
+struct ExtensionCandidate {
+    GaplessExtension extension;
+    size_t left_head, right_tail;
+
+    bool operator<(const ExtensionCandidate& another) const {
+        return (this->extension < another.extension);
+    }
+};
 
 //------------------------------------------------------------------------------
 
@@ -518,6 +538,14 @@ std::vector<GaplessExtension> GaplessExtender::extend(cluster_type& cluster, std
         cache = new gbwtgraph::CachedGBWTGraph(*(this->graph));
     }
 
+    // Reuse the search structures between seeds. The queue is a max-heap.
+    PathBuffer paths;
+    std::vector<ExtensionCandidate> extensions;
+    auto push_extension = [&](ExtensionCandidate&& candidate) {
+        extensions.emplace_back(std::move(candidate));
+        std::push_heap(extensions.begin(), extensions.end());
+    };
+
     // Find the best extension starting from each seed.
     size_t best_alignment = std::numeric_limits<size_t>::max();
     for (seed_type seed : cluster) {
@@ -529,20 +557,24 @@ std::vector<GaplessExtension> GaplessExtender::extend(cluster_type& cluster, std
             }
         }
 
-        GaplessExtension best_match {
-            { }, static_cast<size_t>(0), gbwt::BidirectionalState(),
-            { static_cast<size_t>(0), static_cast<size_t>(0) }, { },
-            std::numeric_limits<int32_t>::min(), false, false,
-            false, false, std::numeric_limits<uint32_t>::max(), std::numeric_limits<uint32_t>::max()
+        ExtensionCandidate best_match {
+            {
+                { }, static_cast<size_t>(0), gbwt::BidirectionalState(),
+                { static_cast<size_t>(0), static_cast<size_t>(0) }, { },
+                std::numeric_limits<int32_t>::min(), false, false,
+                false, false, std::numeric_limits<uint32_t>::max(), std::numeric_limits<uint32_t>::max()
+            },
+            PathBuffer::NO_PARENT, PathBuffer::NO_PARENT
         };
 
         // Match the initial node and add it to the queue.
-        std::priority_queue<GaplessExtension> extensions;
+        paths.clear();
+        extensions.clear();
         {
             size_t read_offset = get_read_offset(seed);
             size_t node_offset = get_node_offset(seed);
             GaplessExtension match {
-                { seed.first }, node_offset, cache->get_bd_state(seed.first),
+                { }, node_offset, cache->get_bd_state(seed.first),
                 { read_offset, read_offset }, { },
                 static_cast<int32_t>(0), false, false,
                 false, false, static_cast<uint32_t>(0), static_cast<uint32_t>(0)
@@ -557,14 +589,16 @@ std::vector<GaplessExtension> GaplessExtender::extend(cluster_type& cluster, std
                 match.right_maximal = true;
             }
             set_score(match, this->aligner);
-            extensions.push(std::move(match));
+            push_extension({ std::move(match), PathBuffer::NO_PARENT, paths.extend(PathBuffer::NO_PARENT, seed.first) });
         }
 
         // Extend the most promising extensions first, using alignment scores for priority.
         // First make the extension right-maximal and then left-maximal.
         while (!extensions.empty()) {
-            GaplessExtension curr = std::move(extensions.top());
-            extensions.pop();
+            std::pop_heap(extensions.begin(), extensions.end());
+            ExtensionCandidate curr_candidate = std::move(extensions.back());
+            extensions.pop_back();
+            GaplessExtension& curr = curr_candidate.extension;
 
             // Case 1: Extend to the right.
             if (!curr.right_maximal) {
@@ -585,7 +619,7 @@ std::vector<GaplessExtension> GaplessExtender::extend(cluster_type& cluster, std
                     if (node_offset == 0) { // Did not match anything.
                         return true;
                     }
-                    next.path = get_path(curr.path, handle);
+                    size_t right_tail = paths.extend(curr_candidate.right_tail, handle);
                     // Did the extension become right-maximal?
                     if (next.read_interval.second >= sequence.length()) {
                         next.right_full = true;
@@ -597,7 +631,7 @@ std::vector<GaplessExtension> GaplessExtender::extend(cluster_type& cluster, std
                     }
                     set_score(next, this->aligner);
                     num_extensions += next.state.size();
-                    extensions.push(std::move(next));
+                    push_extension({ std::move(next), curr_candidate.left_head, right_tail });
                     return true;
                 });
                 // We could not extend all threads in 'curr' to the right. The unextended ones
@@ -605,7 +639,7 @@ std::vector<GaplessExtension> GaplessExtender::extend(cluster_type& cluster, std
                 if (num_extensions < curr.state.size()) {
                     curr.right_maximal = true;
                     curr.old_score = curr.internal_score;
-                    extensions.push(std::move(curr));
+                    push_extension(std::move(curr_candidate));
                 }
                 continue;
             }
@@ -630,7 +664,7 @@ std::vector<GaplessExtension> GaplessExtender::extend(cluster_type& cluster, std
                     if (next.offset >= node_length) { // Did not match anything.
                         return true;
                     }
-                    next.path = get_path(handle, curr.path);
+                    size_t left_head = paths.extend(curr_candidate.left_head, handle);
                     // Did the extension become left-maximal?
                     if (next.read_interval.first == 0) {
                         next.left_full = true;
@@ -641,7 +675,7 @@ std::vector<GaplessExtension> GaplessExtender::extend(cluster_type& cluster, std
                         // No need to set old_score.
                     }
                     set_score(next, this->aligner);
-                    extensions.push(std::move(next));
+                    push_extension({ std::move(next), left_head, curr_candidate.right_tail });
                     found_extension = true;
                     return true;
                 });
@@ -654,17 +688,19 @@ std::vector<GaplessExtension> GaplessExtender::extend(cluster_type& cluster, std
             }
 
             // Case 3: Maximal extension with a better score than the best extension so far.
-            if (best_match < curr) {
-                best_match = std::move(curr);
+            if (best_match < curr_candidate) {
+                best_match = std::move(curr_candidate);
             }
         }
 
         // Add the best match to the result and update the best_alignment offset.
-        if (!best_match.empty()) {
-            if (best_match.full() && (best_alignment >= result.size() || best_match.internal_score < result[best_alignment].internal_score)) {
+        GaplessExtension& best = best_match.extension;
+        if (!best.empty()) {
+            if (best.full() && (best_alignment >= result.size() || best.internal_score < result[best_alignment].internal_score)) {
                 best_alignment = result.size();
             }
-            result.emplace_back(std::move(best_match));
+            paths.get_path(best_match.left_head, best_match.right_tail, best.path);
+            result.emplace_back(std::move(best));
         }
     }
 
@@ -17,8 +17,9 @@ namespace vg {
 
 using namespace std;
 
-/// Export the given VG graph to the given GFA file.
-void graph_to_gfa(const unique_ptr<PathHandleGraph>& graph, ostream& out);
+/// Export the given VG graph to the given GFA file, optionally BGZF-compressed.
+/// Formatting is done in parallel using the OMP thread count.
+void graph_to_gfa(const unique_ptr<PathHandleGraph>& graph, ostream& out, bool bgzip = false);
 
 
 }
@@ -1,6 +1,9 @@
 #include "graph_caller.hpp"
 #include "algorithms/expand_context.hpp"
 
+#include <fstream>
+#include <queue>
+
 //#define debug
 
 namespace vg {
@@ -177,6 +180,7 @@ vector<Chain> GraphCaller::break_chain(const HandleGraph& graph, const Chain& ch
     
 VCFOutputCaller::VCFOutputCaller(const string& sample_name) : sample_name(sample_name) {
     output_variants.resize(get_thread_count());
+    spilled_variant_files.resize(get_thread_count());
 }
 
 VCFOutputCaller::~VCFOutputCaller() {
@@ -205,22 +209,144 @@ string VCFOutputCaller::vcf_header(const PathHandleGraph& graph, const vector<st
     return ss.str();
 }
 
+/// order variants by contig name and then position
+static bool variant_less(const vcflib::Variant& v1, const vcflib::Variant& v2) {
+    return v1.sequenceName < v2.sequenceName || (v1.sequenceName == v2.sequenceName && v1.position < v2.position);
+}
+
 void VCFOutputCaller::add_variant(vcflib::Variant& var) const {
-    output_variants[omp_get_thread_num()].push_back(var);
+    size_t thread_number = omp_get_thread_num();
+    output_variants[thread_number].push_back(var);
+    if (max_buffered_variants > 0 && output_variants[thread_number].size() >= max_buffered_variants) {
+        spill_variants(thread_number);
+    }
 }
 
-void VCFOutputCaller::write_variants(ostream& out_stream) const {
-    vector<vcflib::Variant> all_variants;
-    for (const auto& buf : output_variants) {
-        all_variants.reserve(all_variants.size() + buf.size());
-        std::move(buf.begin(), buf.end(), std::back_inserter(all_variants));
+void VCFOutputCaller::set_max_buffered_variants(size_t max_variants) {
+    max_buffered_variants = max_variants;
+}
+
+void VCFOutputCaller::spill_variants(size_t thread_number) const {
+    vector<vcflib::Variant>& buf = output_variants[thread_number];
+    std::sort(buf.begin(), buf.end(), variant_less);
+    
+    string spill_file = temp_file::create("vg-call-");
+    ofstream spill_stream(spill_file);
+    if (!spill_stream) {
+        cerr << "error:[vg call] unable to write variants to temporary file " << spill_file << endl;
+        exit(1);
     }
-    std::sort(all_variants.begin(), all_variants.end(), [](const vcflib::Variant& v1, const vcflib::Variant& v2) {
-            return v1.sequenceName < v2.sequenceName || (v1.sequenceName == v2.sequenceName && v1.position < v2.position);
-        });
-    for (auto v : all_variants) {
+    for (auto& v : buf) {
         v.setVariantCallFile(output_vcf);
-        out_stream << v << endl;
+        spill_stream << v << "\n";
+    }
+    spill_stream.close();
+    
+    spilled_variant_files[thread_number].push_back(spill_file);
+    buf.clear();
+    buf.shrink_to_fit();
+}
+
+/// most sorted runs of spilled variants to have open at once when merging
+static const size_t max_merge_fan_in = 64;
+
+/// merge sorted runs of variant lines from the given files into out_stream
+static void merge_variant_runs(const vector<string>& run_files, ostream& out_stream) {
+    // Merge the runs, keyed on the contig name and position of the next line in each
+    struct RunHead {
+        string contig;
+        size_t position;
+        string line;
+        size_t run;
+    };
+    auto head_greater = [](const RunHead& h1, const RunHead& h2) {
+        return h1.contig > h2.contig || (h1.contig == h2.contig && h1.position > h2.position);
+    };
+    vector<unique_ptr<ifstream>> run_streams;
+    priority_queue<RunHead, vector<RunHead>, decltype(head_greater)> heads(head_greater);
+    auto advance = [&](size_t run) {
+        RunHead head;
+        if (getline(*run_streams[run], head.line)) {
+            size_t contig_end = head.line.find('\t');
+            size_t position_end = head.line.find('\t', contig_end + 1);
+            head.contig = head.line.substr(0, contig_end);
+            head.position = parse<size_t>(head.line.substr(contig_end + 1, position_end - contig_end - 1));
+            head.run = run;
+            heads.push(std::move(head));
+        }
+    };
+    for (size_t i = 0; i < run_files.size(); ++i) {
+        run_streams.emplace_back(new ifstream(run_files[i]));
+        if (!*run_streams.back()) {
+            cerr << "error:[vg call] unable to read variants from temporary file " << run_files[i] << endl;
+            exit(1);
+        }
+        advance(i);
+    }
+    while (!heads.empty()) {
+        RunHead head = heads.top();
+        heads.pop();
+        out_stream << head.line << "\n";
+        advance(head.run);
+    }
+    out_stream << flush;
+}
+
+void VCFOutputCaller::write_variants(ostream& out_stream) const {
+    bool spilled = std::any_of(spilled_variant_files.begin(), spilled_variant_files.end(),
+                               [](const vector<string>& files) {return !files.empty();});
+    
+    if (!spilled) {
+        vector<vcflib::Variant> all_variants;
+        for (const auto& buf : output_variants) {
+            all_variants.reserve(all_variants.size() + buf.size());
+            std::move(buf.begin(), buf.end(), std::back_inserter(all_variants));
+        }
+        std::sort(all_variants.begin(), all_variants.end(), variant_less);
+        for (auto v : all_variants) {
+            v.setVariantCallFile(output_vcf);
+            out_stream << v << endl;
+        }
+        return;
+    }
+
+    // Everything still in memory becomes one more sorted run
+    vector<string> run_files;
+    for (size_t i = 0; i < output_variants.size(); ++i) {
+        if (!output_variants[i].empty()) {
+            spill_variants(i);
+        }
+        run_files.insert(run_files.end(), spilled_variant_files[i].begin(), spilled_variant_files[i].end());
+        spilled_variant_files[i].clear();
+    }
+
+    // Only have so many runs open at once, so we stay under the open file
+    // limit: merge groups of runs into longer runs until few enough are left
+    while (run_files.size() > max_merge_fan_in) {
+        vector<string> merged_files;
+        for (size_t i = 0; i < run_files.size(); i += max_merge_fan_in) {
+            vector<string> group(run_files.begin() + i,
+                                 run_files.begin() + std::min(i + max_merge_fan_in, run_files.size()));
+            string merged_file = temp_file::create("vg-call-");
+            ofstream merged_stream(merged_file);
+            if (!merged_stream) {
+                cerr << "error:[vg call] unable to write variants to temporary file " << merged_file << endl;
+                exit(1);
+            }
+            merge_variant_runs(group, merged_stream);
+            merged_stream.close();
+            for (const string& run_file : group) {
+                temp_file::remove(run_file);
+            }
+            merged_files.push_back(merged_file);
+        }
+        run_files = std::move(merged_files);
+    }
+
+    merge_variant_runs(run_files, out_stream);
+
+    for (const string& run_file : run_files) {
+        temp_file::remove(run_file);
     }
 }
 
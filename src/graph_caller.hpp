@@ -79,8 +79,14 @@ public:
     /// Add a variant to our buffer
     void add_variant(vcflib::Variant& var) const;
 
-    /// Sort then write variants in the buffer
+    /// Sort then write variants in the buffer.  If any variants were spilled
+    /// to disk, the sorted runs are merged in order, a bounded number at a time.
     void write_variants(ostream& out_stream) const;
+
+    /// Bound memory by writing each thread's buffer as a sorted run to a temporary
+    /// file once it holds this many variants (0 to keep all variants in memory).
+    /// The VCF header must be generated (by vcf_header()) before any variants are added.
+    void set_max_buffered_variants(size_t max_variants);
     
 protected:
 
@@ -108,6 +114,15 @@ protected:
     /// output buffers (1/thread) (for sorting)
     mutable vector<vector<vcflib::Variant>> output_variants;
 
+    /// sort and write a thread's output buffer to a new temporary file, then clear it
+    void spill_variants(size_t thread_number) const;
+
+    /// spill output buffers once they get this big (0 = never)
+    size_t max_buffered_variants = 0;
+
+    /// temporary files of sorted variants spilled from the output buffers (1/thread)
+    mutable vector<vector<string>> spilled_variant_files;
+
     /// print up to this many uncalled alleles when doing ref-genotpes in -a mode
     size_t max_uncalled_alleles = 5;
 };
@@ -44,6 +44,32 @@ std::vector<std::string> HaplotypeIndexer::parse_vcf(const std::string& filename
 
 std::vector<std::string> HaplotypeIndexer::parse_vcf(const std::string& filename, const PathHandleGraph& graph, const std::vector<path_handle_t>& paths, const std::string& job_name) const {
 
+    std::vector<std::string> result;
+    this->parse_vcf(filename, graph, paths, job_name, false,
+        [&](const std::string& vcf_contig_name, gbwt::VariantPaths& variants, const std::vector<std::string>&) {
+        std::string parse_file = (this->batch_file_prefix.empty() ? gbwt::TempFile::getName("parse") : this->batch_file_prefix + '_' + vcf_contig_name);
+        if (this->show_progress) {
+            #pragma omp critical
+            {
+                std::cerr << job_name << ": Saving the VCF parse for path " << variants.getContigName() << " to " << parse_file << std::endl;
+            }
+        }
+
+        // Save the VCF parse.
+        if (!sdsl::store_to_file(variants, parse_file)) {
+            std::cerr << "error: [HaplotypeIndexer::parse_vcf] cannot write parse file " << parse_file << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        result.push_back(parse_file);
+    });
+
+    return result;
+}
+
+void HaplotypeIndexer::parse_vcf(const std::string& filename, const PathHandleGraph& graph, const std::vector<path_handle_t>& paths,
+    const std::string& job_name, bool temporary_batches,
+    const std::function<void(const std::string& vcf_contig_name, gbwt::VariantPaths& variants, const std::vector<std::string>& batch_files)>& parse_callback) const {
+
     // Open the VCF file.
     vcflib::VariantCallFile variant_file;
     variant_file.parseSamples = false; // vcflib parsing is very slow if there are many samples.
@@ -87,7 +113,6 @@ std::vector<std::string> HaplotypeIndexer::parse_vcf(const std::string& filename
     }
 
     // Parse the contigs we are interested in.
-    std::vector<std::string> result;
     size_t total_variants_processed = 0;
     std::mt19937 rng(0xDEADBEEF);
     std::uniform_int_distribution<std::mt19937::result_type> random_bit(0, 1);
@@ -123,7 +148,7 @@ std::vector<std::string> HaplotypeIndexer::parse_vcf(const std::string& filename
         }
 
         // Structures to parse the VCF file into.
-        std::string parse_file = (this->batch_file_prefix.empty() ? gbwt::TempFile::getName("parse") : this->batch_file_prefix + '_' + vcf_contig_name);
+        std::string batch_prefix = (this->batch_file_prefix.empty() || temporary_batches ? "" : this->batch_file_prefix + '_' + vcf_contig_name);
         gbwt::VariantPaths variants(graph.get_step_count(paths[path_id]));
         variants.setSampleNames(sample_names);
         variants.setContigName(path_name);
@@ -138,9 +163,9 @@ std::vector<std::string> HaplotypeIndexer::parse_vcf(const std::string& filename
         // Create a PhasingInformation file for each batch.
         for (size_t batch_start = sample_range.first; batch_start < sample_range.second; batch_start += samples_in_batch) {
             size_t batch_size = std::min(samples_in_batch, sample_range.second - batch_start);
-            if (!this->batch_file_prefix.empty()) {
+            if (!batch_prefix.empty()) {
                 // Use a permanent file.
-                phasings.emplace_back(parse_file, batch_start, batch_size);
+                phasings.emplace_back(batch_prefix, batch_start, batch_size);
             } else {
                 // Use a temporary file that persists until the program exits.
                 phasings.emplace_back(batch_start, batch_size);
@@ -266,16 +291,17 @@ std::vector<std::string> HaplotypeIndexer::parse_vcf(const std::string& filename
             #pragma omp critical
             {
                 std::cerr << job_name << ": Processed " << variants_processed << " variants on path " << path_name << ", " << gbwt::inMegabytes(phasing_bytes) << " MiB phasing information" << std::endl;
-                std::cerr << job_name << ": Saving the VCF parse for path " << path_name << " to " << parse_file << std::endl;
             }
         }
 
-        // Save the VCF parse.
-        if (!sdsl::store_to_file(variants, parse_file)) {
-            std::cerr << "error: [HaplotypeIndexer::parse_vcf] cannot write parse file " << parse_file << std::endl;
-            std::exit(EXIT_FAILURE);
+        // Close the phasing batches before handing the parse over, so that
+        // the batch files can be read back.
+        std::vector<std::string> batch_files;
+        for (size_t batch = 0; batch < phasings.size(); batch++) {
+            batch_files.push_back(phasings[batch].name());
         }
-        result.push_back(parse_file);
+        phasings.clear();
+        parse_callback(vcf_contig_name, variants, batch_files);
 
         // End of haplotype generation for the current contig.
         total_variants_processed += variants_processed;
@@ -288,8 +314,6 @@ std::vector<std::string> HaplotypeIndexer::parse_vcf(const std::string& filename
                 << " variants in phasing VCF but not in graph! Do your graph and VCF match?" << std::endl;
         }
     }
-
-    return result;
 }
 
 std::unique_ptr<gbwt::DynamicGBWT> HaplotypeIndexer::build_gbwt(const std::vector<std::string>& vcf_parse_files, const std::string& job_name) const {
@@ -322,40 +346,101 @@ std::unique_ptr<gbwt::DynamicGBWT> HaplotypeIndexer::build_gbwt(const std::vecto
             std::cerr << "error: [HaplotypeIndexer::build_gbwt] invalid sample names in VCF parse file " << filename << std::endl;
             std::exit(EXIT_FAILURE);
         }
-        contig_names.emplace_back(variants.getContigName());
         if (this->show_progress) {
             #pragma omp critical
             {
                 std::cerr << job_name << ": Generating haplotypes for path " << variants.getContigName() << " from file " << filename << std::endl;
             }
         }
-        gbwt::GBWTBuilder builder(variants.nodeWidth(true), this->gbwt_buffer_size * gbwt::MILLION, this->id_interval);
-        builder.swapIndex(*index);
-        gbwt::generateHaplotypes(variants, std::set<std::string>(),
-        [&](gbwt::size_type sample_id) -> bool {
-            return (this->excluded_samples.find(sample_names[sample_id]) == this->excluded_samples.end());
-        }, [&](const gbwt::Haplotype& haplotype) {
-            builder.insert(haplotype.path, true); // Insert in both orientations.
-            builder.index.metadata.addPath(haplotype.sample, contig_names.size() - 1, haplotype.phase, haplotype.count);
-            haplotypes.insert(gbwt::range_type(haplotype.sample, haplotype.phase));
-        }, [&](gbwt::size_type, gbwt::size_type) -> bool {
-            // For each overlap, discard it if our global flag is set.
-            return this->discard_overlaps;
-        });
-        builder.finish();
-        builder.swapIndex(*index);
+        this->generate_haplotypes(variants, *index, sample_names, contig_names, haplotypes);
     }
 
     // Finish the construction.
-    index->metadata.setSamples(sample_names);
-    index->metadata.setContigs(contig_names);
-    index->metadata.setHaplotypes(haplotypes.size());
+    this->finish_metadata(*index, sample_names, contig_names, haplotypes, job_name);
+    return index;
+}
+
+std::unique_ptr<gbwt::DynamicGBWT> HaplotypeIndexer::build_gbwt(const std::string& vcf_filename, const PathHandleGraph& graph, const std::vector<path_handle_t>& paths, const std::string& job_name) const {
+
+    double start = gbwt::readTimer();
+
+    // GBWT metadata.
+    std::vector<std::string> sample_names, contig_names;
+    std::set<gbwt::range_type> haplotypes;
+
+    // GBWT index.
+    std::unique_ptr<gbwt::DynamicGBWT> index(new gbwt::DynamicGBWT());
+    index->addMetadata();
+
+    // Hand each contig parse directly to the builder, and drop the phasing
+    // batches as soon as the haplotypes have been generated.
+    size_t parse_bytes = 0;
+    this->parse_vcf(vcf_filename, graph, paths, job_name, true,
+        [&](const std::string&, gbwt::VariantPaths& variants, const std::vector<std::string>& batch_files) {
+        sample_names = variants.getSampleNames();
+        if (this->show_progress) {
+            #pragma omp critical
+            {
+                std::cerr << job_name << ": Generating haplotypes for path " << variants.getContigName() << " without a parse file" << std::endl;
+            }
+        }
+        this->generate_haplotypes(variants, *index, sample_names, contig_names, haplotypes);
+        parse_bytes += sdsl::size_in_bytes(variants);
+        for (std::string batch_file : batch_files) {
+            gbwt::TempFile::remove(batch_file);
+        }
+    });
+
+    // Finish the construction.
+    if (contig_names.empty()) {
+        return index;
+    }
+    this->finish_metadata(*index, sample_names, contig_names, haplotypes, job_name);
+    if (this->show_progress) {
+        double seconds = gbwt::readTimer() - start;
+        #pragma omp critical
+        {
+            std::cerr << job_name << ": Streamed " << contig_names.size() << " contigs in " << seconds << " seconds; skipped writing and reading "
+                << gbwt::inMegabytes(parse_bytes) << " MiB of VCF parses" << std::endl;
+        }
+    }
+    return index;
+}
+
+void HaplotypeIndexer::generate_haplotypes(const gbwt::VariantPaths& variants, gbwt::DynamicGBWT& index,
+    std::vector<std::string>& sample_names, std::vector<std::string>& contig_names,
+    std::set<gbwt::range_type>& haplotypes) const {
+
+    contig_names.emplace_back(variants.getContigName());
+    gbwt::GBWTBuilder builder(variants.nodeWidth(true), this->gbwt_buffer_size * gbwt::MILLION, this->id_interval);
+    builder.swapIndex(index);
+    gbwt::generateHaplotypes(variants, std::set<std::string>(),
+    [&](gbwt::size_type sample_id) -> bool {
+        return (this->excluded_samples.find(sample_names[sample_id]) == this->excluded_samples.end());
+    }, [&](const gbwt::Haplotype& haplotype) {
+        builder.insert(haplotype.path, true); // Insert in both orientations.
+        builder.index.metadata.addPath(haplotype.sample, contig_names.size() - 1, haplotype.phase, haplotype.count);
+        haplotypes.insert(gbwt::range_type(haplotype.sample, haplotype.phase));
+    }, [&](gbwt::size_type, gbwt::size_type) -> bool {
+        // For each overlap, discard it if our global flag is set.
+        return this->discard_overlaps;
+    });
+    builder.finish();
+    builder.swapIndex(index);
+}
+
+void HaplotypeIndexer::finish_metadata(gbwt::DynamicGBWT& index, const std::vector<std::string>& sample_names,
+    const std::vector<std::string>& contig_names, const std::set<gbwt::range_type>& haplotypes,
+    const std::string& job_name) const {
+
+    index.metadata.setSamples(sample_names);
+    index.metadata.setContigs(contig_names);
+    index.metadata.setHaplotypes(haplotypes.size());
     if (this->show_progress) {
         std::cerr << job_name << ": ";
-        gbwt::operator<<(std::cerr, index->metadata);
+        gbwt::operator<<(std::cerr, index.metadata);
         std::cerr << std::endl;
     }
-    return index;
 }
 
 std::unique_ptr<gbwt::DynamicGBWT> HaplotypeIndexer::build_gbwt(const PathHandleGraph& graph) const {
@@ -7,8 +7,10 @@
 
 #include <string>
 #include <utility>
+#include <functional>
 #include <map>
 #include <memory>
+#include <set>
 #include <unordered_set>
 #include <vector>
 
@@ -117,6 +119,18 @@ public:
      */
     std::unique_ptr<gbwt::DynamicGBWT> build_gbwt(const std::vector<std::string>& vcf_parse_files, const std::string& job_name = "GBWT") const;
 
+    /**
+     * Build a GBWT directly from the VCF file without storing intermediate
+     * VCF parse files. Each contig is parsed and its haplotypes are
+     * immediately inserted into the GBWT, after which the phasing batches
+     * for that contig are deleted. Scratch space is therefore bounded by
+     * the phasing information for a single contig, and the parses are never
+     * written out and read back.
+     *
+     * Ignores batch_file_prefix. Respects excluded_samples.
+     */
+    std::unique_ptr<gbwt::DynamicGBWT> build_gbwt(const std::string& vcf_filename, const PathHandleGraph& graph, const std::vector<path_handle_t>& paths, const std::string& job_name = "GBWT") const;
+
     /**
      * Build a GBWT from the embedded non-alt paths in the graph. Use
      * paths_as_samples to choose whether we treat the paths as contigs or
@@ -134,6 +148,32 @@ public:
      */
     std::unique_ptr<gbwt::DynamicGBWT> build_gbwt(const PathHandleGraph& graph,
         const std::vector<std::string>& aln_filenames, const std::string& aln_format) const;
+
+private:
+
+    /**
+     * Parse the VCF file for the given paths. For each contig present in the
+     * file, call the callback with the parse and the names of the phasing
+     * batch files it refers to, once the batch files have been closed.
+     * If temporary_batches is set, the batch files are always temporary
+     * files, regardless of batch_file_prefix.
+     */
+    void parse_vcf(const std::string& filename, const PathHandleGraph& graph, const std::vector<path_handle_t>& paths,
+        const std::string& job_name, bool temporary_batches,
+        const std::function<void(const std::string& vcf_contig_name, gbwt::VariantPaths& variants, const std::vector<std::string>& batch_files)>& parse_callback) const;
+
+    /**
+     * Generate the haplotypes for a single contig parse and insert them into
+     * the index, updating the metadata collected so far.
+     */
+    void generate_haplotypes(const gbwt::VariantPaths& variants, gbwt::DynamicGBWT& index,
+        std::vector<std::string>& sample_names, std::vector<std::string>& contig_names,
+        std::set<gbwt::range_type>& haplotypes) const;
+
+    /// Store the collected metadata in the index.
+    void finish_metadata(gbwt::DynamicGBWT& index, const std::vector<std::string>& sample_names,
+        const std::vector<std::string>& contig_names, const std::set<gbwt::range_type>& haplotypes,
+        const std::string& job_name) const;
 };
 
 }
@@ -5198,14 +5198,42 @@ FragmentLengthDistribution::FragmentLengthDistribution() : FragmentLengthDistrib
     
 }
     
+FragmentLengthDistribution::FragmentLengthDistribution(const FragmentLengthDistribution& other) {
+    *this = other;
+}
+
+FragmentLengthDistribution& FragmentLengthDistribution::operator=(const FragmentLengthDistribution& other) {
+    if (this != &other) {
+        lengths = other.lengths;
+        is_fixed = other.is_fixed.load();
+        robust_estimation_fraction = other.robust_estimation_fraction;
+        maximum_sample_size = other.maximum_sample_size;
+        reestimation_frequency = other.reestimation_frequency;
+        mu = other.mu;
+        sigma = other.sigma;
+    }
+    return *this;
+}
+
 FragmentLengthDistribution::~FragmentLengthDistribution() {
     
 }
 
 void FragmentLengthDistribution::force_parameters(double mean, double stddev) {
-    mu = mean;
-    sigma = stddev;
-    is_fixed = true;
+    // don't race with an estimate being made in register_fragment_length()
+#pragma omp critical
+    {
+        mu = mean;
+        sigma = stddev;
+        is_fixed = true;
+    }
+}
+
+void FragmentLengthDistribution::finalize() {
+#pragma omp critical
+    {
+        is_fixed = true;
+    }
 }
 
 void FragmentLengthDistribution::register_fragment_length(int64_t length) {
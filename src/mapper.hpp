@@ -5,6 +5,7 @@
 #include <map>
 #include <chrono>
 #include <ctime>
+#include <atomic>
 #include "omp.h"
 #include "vg.hpp"
 #include "bdsg/hash_graph.hpp"
@@ -92,6 +93,8 @@ public:
 /*
  * A class that keeps a running estimation of a fragment length distribution
  * using a robust estimation formula in order to be insensitive to outliers.
+ * Fragment lengths can be registered from many threads at once, and the
+ * parameters can be read without locking once the distribution is finalized.
  */
 class FragmentLengthDistribution {
 public:
@@ -106,12 +109,17 @@ public:
                                size_t reestimation_frequency,
                                double robust_estimation_fraction);
     FragmentLengthDistribution(void);
+    FragmentLengthDistribution(const FragmentLengthDistribution& other);
+    FragmentLengthDistribution& operator=(const FragmentLengthDistribution& other);
     ~FragmentLengthDistribution();
     
     
     /// Instead of estimating anything, just use these parameters.
     void force_parameters(double mean, double stddev);
     
+    /// Stop estimating and keep the current parameters.
+    void finalize();
+    
     /// Record an observed fragment length
     void register_fragment_length(int64_t length);
 
@@ -142,7 +150,7 @@ public:
     
 private:
     multiset<double> lengths;
-    bool is_fixed = false;
+    atomic<bool> is_fixed{false};
     
     double robust_estimation_fraction;
     size_t maximum_sample_size;
@@ -25,6 +25,21 @@ using namespace std;
     }
     
     handle_t MemoizingGraph::get_handle(const id_t& node_id, bool is_reverse) const {
+        if (use_flat_memo) {
+            auto& flat_memo = const_cast<MemoizingGraph*>(this)->get_handle_flat_memo;
+            const handle_t* memoized = flat_memo.find(node_id);
+            if (memoized) {
+                return is_reverse ? graph->flip(*memoized) : *memoized;
+            }
+            else if (flat_memo.size() < max_handle_memo_size) {
+                handle_t handle = flat_memo.insert(node_id, graph->get_handle(node_id), max_handle_memo_size);
+                return is_reverse ? graph->flip(handle) : handle;
+            }
+            else {
+                return graph->get_handle(node_id, is_reverse);
+            }
+        }
+        
         // we have to do some ugly stuff to keep libhandlegraph's const requirements while still
         // updating memos
         auto& memo = const_cast<MemoizingGraph*>(this)->get_handle_memo;
@@ -167,6 +182,28 @@ using namespace std;
     std::vector<step_handle_t> MemoizingGraph::steps_of_handle(const handle_t& handle,
                                                                bool match_orientation) const {
         
+        if (use_flat_memo) {
+            auto& flat_memo = const_cast<MemoizingGraph*>(this)->steps_of_handle_flat_memo;
+            const vector<step_handle_t>* steps = flat_memo.find(forward(handle));
+            if (!steps) {
+                if (flat_memo.size() >= max_steps_of_handle_memo_size) {
+                    return graph->steps_of_handle(handle, match_orientation);
+                }
+                steps = &flat_memo.insert(forward(handle), graph->steps_of_handle(handle),
+                                          max_steps_of_handle_memo_size);
+            }
+            if (!match_orientation) {
+                return *steps;
+            }
+            vector<step_handle_t> to_return;
+            for (const step_handle_t& step : *steps) {
+                if (graph->get_is_reverse(graph->get_handle_of_step(step)) == graph->get_is_reverse(handle)) {
+                    to_return.push_back(step);
+                }
+            }
+            return to_return;
+        }
+        
         // we have to do some ugly stuff to keep libhandlegraph's const requirements while still
         // updating memos
         auto& memo = const_cast<MemoizingGraph*>(this)->steps_of_handle_memo;
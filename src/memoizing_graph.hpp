@@ -9,11 +9,78 @@
 #include "handle.hpp"
 
 #include <unordered_map>
+#include <vector>
 
 namespace vg {
 
 using namespace std;
 
+    /**
+     * A small open-addressed hash table with linear probing, for memos that
+     * only ever grow to a bounded size and are thrown away whole. The table
+     * is allocated on the first insert with room for twice the maximum number
+     * of entries, so probes stay short and nothing is ever rehashed.
+     */
+    template<typename Key, typename Value, typename Hash = std::hash<Key>>
+    class FlatMemo {
+    public:
+        
+        /// Find the value memoized for the key, or return nullptr if there is none.
+        inline const Value* find(const Key& key) const {
+            if (slots.empty()) {
+                return nullptr;
+            }
+            for (size_t i = slot_of(key); occupied[i]; i = (i + 1) & mask) {
+                if (slots[i].first == key) {
+                    return &slots[i].second;
+                }
+            }
+            return nullptr;
+        }
+        
+        /// Memoize a value for a key that isn't memoized yet, and return a
+        /// reference to it. The memo must hold fewer than max_size entries.
+        inline Value& insert(const Key& key, Value value, size_t max_size) {
+            if (slots.empty()) {
+                size_t capacity = 2;
+                shift = 63;
+                while (capacity < 2 * max_size) {
+                    capacity *= 2;
+                    --shift;
+                }
+                slots.resize(capacity);
+                occupied.resize(capacity, false);
+                mask = capacity - 1;
+            }
+            size_t i = slot_of(key);
+            while (occupied[i]) {
+                i = (i + 1) & mask;
+            }
+            occupied[i] = true;
+            slots[i] = make_pair(key, std::move(value));
+            ++filled;
+            return slots[i].second;
+        }
+        
+        /// Return the number of memoized entries.
+        inline size_t size() const {
+            return filled;
+        }
+        
+    private:
+        /// Pick the home slot for a key by Fibonacci hashing, so that keys
+        /// with regular low bits (like handles) still spread out.
+        inline size_t slot_of(const Key& key) const {
+            return (uint64_t(Hash()(key)) * 0x9E3779B97F4A7C15ull) >> shift;
+        }
+        
+        vector<pair<Key, Value>> slots;
+        vector<bool> occupied;
+        size_t mask = 0;
+        size_t shift = 63;
+        size_t filled = 0;
+    };
+
     /**
      * A PathPositionHandleGraph implementation that memoizes the results of get_handle
      * and steps_of_handle.
@@ -202,6 +269,10 @@ using namespace std;
         /// The largest number of calls to steps_of_handle we will memoize
         size_t max_steps_of_handle_memo_size = 500;
         
+        /// Use the flat open-addressed memos instead of unordered_maps. Must be
+        /// set before any memoized operations.
+        bool use_flat_memo = true;
+        
     private:
         /// The graph we're memoizing operations for
         const PathPositionHandleGraph* graph = nullptr;
@@ -211,6 +282,12 @@ using namespace std;
         
         /// Memo for steps_of_handle
         unordered_map<handle_t, vector<step_handle_t>> steps_of_handle_memo;
+        
+        /// Flat memo for get_handle
+        FlatMemo<id_t, handle_t> get_handle_flat_memo;
+        
+        /// Flat memo for steps_of_handle
+        FlatMemo<handle_t, vector<step_handle_t>> steps_of_handle_flat_memo;
     };
 }
 
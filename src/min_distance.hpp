@@ -50,8 +50,9 @@ class MinimumDistanceIndex {
     int64_t node_length(id_t id) const;
 
     ///Get the minimum distance between two positions
-    /// Distance includes only one of the positions. The distance from a 
-    /// position to itself would be 1
+    /// This is the number of bases stepped over to get from pos1 to pos2, so
+    /// the distance from a position to itself is 0 and the distance to the
+    /// next base is 1
     ///If there is no path between the two positions then the distance is -1
     int64_t min_distance( pos_t pos1, pos_t pos2) const;
 
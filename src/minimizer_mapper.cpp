@@ -10,6 +10,7 @@
 #include "multipath_alignment.hpp"
 #include "split_strand_graph.hpp"
 #include "subgraph.hpp"
+#include "algorithms/extract_connecting_graph.hpp"
 
 #include <bdsg/overlays/strand_split_overlay.hpp>
 #include <gbwtgraph/algorithms.h>
@@ -18,6 +19,8 @@
 #include <iostream>
 #include <algorithm>
 #include <cmath>
+#include <numeric>
+#include <chrono>
 
 // Turn on debugging prints
 //#define debug
@@ -148,6 +151,151 @@ void MinimizerMapper::map(Alignment& aln, AlignmentEmitter& alignment_emitter) {
 
 vector<Alignment> MinimizerMapper::map(Alignment& aln) {
     
+    if (long_read_chaining && do_dp) {
+        // Joining the chain takes gapped alignment, so without dynamic
+        // programming the read can only be mapped the usual way.
+        vector<Alignment> mappings;
+        if (map_long_read(aln, mappings)) {
+            return mappings;
+        }
+        // Otherwise map the read the usual way.
+    }
+    
+    if (adaptive_cluster_training_reads == 0) {
+        // Always use the fixed thresholds.
+        return map_with_cluster_thresholds(aln, cluster_score_threshold, cluster_coverage_threshold, nullptr);
+    }
+    
+    auto start = chrono::steady_clock::now();
+    auto nanoseconds_since_start = [&]() -> size_t {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    };
+    
+    if (!adaptive_clusters.trained.load()) {
+        // Still learning, so map with the fixed thresholds and see where the winner came from.
+        pair<double, double> winner_margins(-1, -1);
+        vector<Alignment> mappings = map_with_cluster_thresholds(aln, cluster_score_threshold,
+                                                                 cluster_coverage_threshold, &winner_margins);
+        observe_adaptive_clusters(winner_margins, winner_margins.first >= 0, nanoseconds_since_start());
+        return mappings;
+    }
+    
+    // Use the learned thresholds, unless the fixed ones are already tighter.
+    double score_threshold = adaptive_clusters.score_threshold;
+    if (cluster_score_threshold != 0) {
+        score_threshold = std::min(score_threshold, cluster_score_threshold);
+    }
+    double coverage_threshold = adaptive_clusters.coverage_threshold;
+    if (cluster_coverage_threshold != 0) {
+        coverage_threshold = std::min(coverage_threshold, cluster_coverage_threshold);
+    }
+    
+    size_t read_number = adaptive_clusters.pruned_reads.fetch_add(1);
+    bool audit = adaptive_cluster_audit_interval != 0 && read_number % adaptive_cluster_audit_interval == 0;
+    // Keep a copy of the read as it came in, if we need to map it again.
+    Alignment original;
+    if (audit) {
+        original = aln;
+    }
+    
+    vector<Alignment> mappings = map_with_cluster_thresholds(aln, score_threshold, coverage_threshold, nullptr);
+    adaptive_clusters.pruned_nanoseconds += nanoseconds_since_start();
+    
+    if (audit) {
+        // See if the fixed thresholds would have put the primary alignment in the same place.
+        vector<Alignment> fixed_mappings = map_with_cluster_thresholds(original, cluster_score_threshold,
+                                                                       cluster_coverage_threshold, nullptr);
+        const Path& pruned_path = mappings.front().path();
+        const Path& fixed_path = fixed_mappings.front().path();
+        bool concordant;
+        if (pruned_path.mapping_size() == 0 || fixed_path.mapping_size() == 0) {
+            concordant = (pruned_path.mapping_size() == 0 && fixed_path.mapping_size() == 0);
+        } else {
+            const Position& pruned_pos = pruned_path.mapping(0).position();
+            const Position& fixed_pos = fixed_path.mapping(0).position();
+            concordant = (pruned_pos.node_id() == fixed_pos.node_id() &&
+                          pruned_pos.offset() == fixed_pos.offset() &&
+                          pruned_pos.is_reverse() == fixed_pos.is_reverse());
+        }
+        adaptive_clusters.audited_reads++;
+        if (concordant) {
+            adaptive_clusters.concordant_reads++;
+        }
+    }
+    
+    return mappings;
+}
+
+void MinimizerMapper::observe_adaptive_clusters(const pair<double, double>& winner_margins, bool has_winner,
+                                                size_t nanoseconds) {
+    adaptive_clusters.training_nanoseconds += nanoseconds;
+    
+    lock_guard<mutex> lock(adaptive_clusters.training_mutex);
+    if (adaptive_clusters.trained.load()) {
+        // Someone else finished training while we were mapping.
+        return;
+    }
+    
+    adaptive_clusters.training_reads++;
+    if (has_winner) {
+        adaptive_clusters.score_margins.push_back(winner_margins.first);
+        adaptive_clusters.coverage_margins.push_back(winner_margins.second);
+    }
+    if (adaptive_clusters.training_reads < adaptive_cluster_training_reads) {
+        return;
+    }
+    
+    // Take the requested quantile of the margins, so almost all the winners
+    // would still have been found.
+    auto quantile = [&](vector<double>& margins) -> double {
+        if (margins.empty()) {
+            return 0;
+        }
+        size_t rank = std::min(margins.size() - 1, (size_t) ceil(adaptive_cluster_quantile * margins.size()));
+        rank = (rank == 0) ? 0 : rank - 1;
+        std::nth_element(margins.begin(), margins.begin() + rank, margins.end());
+        return margins[rank];
+    };
+    if (adaptive_clusters.score_margins.empty()) {
+        // Nothing mapped, so we learned nothing. Keep the fixed thresholds.
+        adaptive_clusters.score_threshold = cluster_score_threshold;
+        adaptive_clusters.coverage_threshold = cluster_coverage_threshold;
+    } else {
+        adaptive_clusters.score_threshold = quantile(adaptive_clusters.score_margins) + adaptive_cluster_score_slack;
+        adaptive_clusters.coverage_threshold = quantile(adaptive_clusters.coverage_margins) + adaptive_cluster_coverage_slack;
+    }
+    adaptive_clusters.trained.store(true);
+}
+
+void MinimizerMapper::report_adaptive_clusters(ostream& out) const {
+    if (!adaptive_clusters.trained.load()) {
+        out << "Adaptive cluster thresholds: not enough reads to train on ("
+            << adaptive_clusters.training_reads << "/" << adaptive_cluster_training_reads << ")" << endl;
+        return;
+    }
+    
+    // Get a rate in reads per second of thread time.
+    auto rate = [](size_t reads, size_t nanoseconds) -> double {
+        return nanoseconds == 0 ? 0 : reads / (nanoseconds / 1e9);
+    };
+    
+    out << "Adaptive cluster thresholds: learned from " << adaptive_clusters.score_margins.size()
+        << " mapped reads of " << adaptive_clusters.training_reads << endl;
+    out << "Cluster score threshold: " << adaptive_clusters.score_threshold
+        << " (fixed: " << cluster_score_threshold << ")" << endl;
+    out << "Cluster coverage threshold: " << adaptive_clusters.coverage_threshold
+        << " (fixed: " << cluster_coverage_threshold << ")" << endl;
+    out << "Reads per thread-second with fixed thresholds: "
+        << rate(adaptive_clusters.training_reads, adaptive_clusters.training_nanoseconds) << endl;
+    out << "Reads per thread-second with learned thresholds: "
+        << rate(adaptive_clusters.pruned_reads, adaptive_clusters.pruned_nanoseconds) << endl;
+    out << "Audited reads with the same primary position: " << adaptive_clusters.concordant_reads
+        << "/" << adaptive_clusters.audited_reads << endl;
+}
+
+vector<Alignment> MinimizerMapper::map_with_cluster_thresholds(Alignment& aln, double score_threshold, double coverage_threshold,
+                                                               pair<double, double>* winner_margins) {
+    
     if (show_work) {
         #pragma omp critical (cerr)
         {
@@ -178,9 +326,11 @@ vector<Alignment> MinimizerMapper::map(Alignment& aln) {
         funnel.substage("score");
     }
     double best_cluster_score = 0.0, second_best_cluster_score = 0.0;
+    double best_cluster_coverage = 0.0;
     for (size_t i = 0; i < clusters.size(); i++) {
         Cluster& cluster = clusters[i];
         this->score_cluster(cluster, i, minimizers, seeds, aln.sequence().length(), funnel);
+        best_cluster_coverage = std::max(best_cluster_coverage, cluster.coverage);
         if (cluster.score > best_cluster_score) {
             second_best_cluster_score = best_cluster_score;
             best_cluster_score = cluster.score;
@@ -201,7 +351,7 @@ vector<Alignment> MinimizerMapper::map(Alignment& aln) {
     // is within pad_cluster_score_threshold of where the cutoff would
     // otherwise be. This ensures that we won't throw away all but one cluster
     // based on score alone, unless it is really bad.
-    double cluster_score_cutoff = best_cluster_score - cluster_score_threshold;
+    double cluster_score_cutoff = best_cluster_score - score_threshold;
     if (cluster_score_cutoff - pad_cluster_score_threshold < second_best_cluster_score) {
         cluster_score_cutoff = std::min(cluster_score_cutoff, second_best_cluster_score);
     }
@@ -219,6 +369,9 @@ vector<Alignment> MinimizerMapper::map(Alignment& aln) {
     SmallBitset minimizer_explored(minimizers.size());
     //How many hits of each minimizer ended up in each extended cluster?
     vector<vector<size_t>> minimizer_extended_cluster_count; 
+    // Which cluster did each set of extensions come from?
+    vector<size_t> extensions_to_cluster;
+    extensions_to_cluster.reserve(clusters.size());
 
     size_t kept_cluster_count = 0;
     
@@ -229,7 +382,7 @@ vector<Alignment> MinimizerMapper::map(Alignment& aln) {
             return ((clusters[a].coverage > clusters[b].coverage) ||
                     (clusters[a].coverage == clusters[b].coverage && clusters[a].score > clusters[b].score));
         },
-        cluster_coverage_threshold, min_extensions, max_extensions,
+        coverage_threshold, min_extensions, max_extensions,
         [&](size_t cluster_num) {
             // Handle sufficiently good clusters in descending coverage order
             
@@ -240,7 +393,7 @@ vector<Alignment> MinimizerMapper::map(Alignment& aln) {
             }
             
             // First check against the additional score filter
-            if (cluster_score_threshold != 0 && cluster.score < cluster_score_cutoff 
+            if (score_threshold != 0 && cluster.score < cluster_score_cutoff 
                 && kept_cluster_count >= min_extensions) {
                 //If the score isn't good enough and we already kept at least min_extensions clusters,
                 //ignore this cluster
@@ -251,7 +404,7 @@ vector<Alignment> MinimizerMapper::map(Alignment& aln) {
                     #pragma omp critical (cerr)
                     {
                         cerr << log_name() << "Cluster " << cluster_num << " fails cluster score cutoff" <<  endl;
-                        cerr << log_name() << "Covers " << clusters[cluster_num].coverage << "/best-" << cluster_coverage_threshold << " of read" << endl;
+                        cerr << log_name() << "Covers " << clusters[cluster_num].coverage << "/best-" << coverage_threshold << " of read" << endl;
                         cerr << log_name() << "Scores " << clusters[cluster_num].score << "/" << cluster_score_cutoff << endl;
                     }
                 }
@@ -268,7 +421,7 @@ vector<Alignment> MinimizerMapper::map(Alignment& aln) {
                 #pragma omp critical (cerr)
                 {
                     cerr << log_name() << "Cluster " << cluster_num << endl;
-                    cerr << log_name() << "Covers " << cluster.coverage << "/best-" << cluster_coverage_threshold << " of read" << endl;
+                    cerr << log_name() << "Covers " << cluster.coverage << "/best-" << coverage_threshold << " of read" << endl;
                     cerr << log_name() << "Scores " << cluster.score << "/" << cluster_score_cutoff << endl;
                 }
             }
@@ -294,6 +447,7 @@ vector<Alignment> MinimizerMapper::map(Alignment& aln) {
             
             // Extend seed hits in the cluster into one or more gapless extensions
             cluster_extensions.emplace_back(std::move(extender.extend(seed_matchings, aln.sequence())));
+            extensions_to_cluster.push_back(cluster_num);
 
             kept_cluster_count ++;
             
@@ -334,7 +488,7 @@ vector<Alignment> MinimizerMapper::map(Alignment& aln) {
                 {
                     
                     cerr << log_name() << "Cluster " << cluster_num << " passes cluster cutoffs but we have too many" <<  endl;
-                    cerr << log_name() << "Covers " << cluster.coverage << "/best-" << cluster_coverage_threshold << " of read" << endl;
+                    cerr << log_name() << "Covers " << cluster.coverage << "/best-" << coverage_threshold << " of read" << endl;
                     cerr << log_name() << "Scores " << cluster.score << "/" << cluster_score_cutoff << endl;
                 }
             }
@@ -348,7 +502,7 @@ vector<Alignment> MinimizerMapper::map(Alignment& aln) {
                 #pragma omp critical (cerr)
                 {
                     cerr << log_name() << "Cluster " << cluster_num << " fails cluster coverage cutoffs" <<  endl;
-                    cerr << log_name() << "Covers " << clusters[cluster_num].coverage << "/best-" << cluster_coverage_threshold << " of read" << endl;
+                    cerr << log_name() << "Covers " << clusters[cluster_num].coverage << "/best-" << coverage_threshold << " of read" << endl;
                     cerr << log_name() << "Scores " << clusters[cluster_num].score << "/" << cluster_score_cutoff << endl;
                 }
             }
@@ -588,6 +742,14 @@ vector<Alignment> MinimizerMapper::map(Alignment& aln) {
         // This alignment makes it
         // Called in score order
         
+        if (winner_margins != nullptr && mappings.empty() &&
+            alignments_to_source[alignment_num] != numeric_limits<size_t>::max()) {
+            // This is the primary alignment, so say how far its cluster was from the best.
+            const Cluster& winner = clusters[extensions_to_cluster[alignments_to_source[alignment_num]]];
+            winner_margins->first = best_cluster_score - winner.score;
+            winner_margins->second = best_cluster_coverage - winner.coverage;
+        }
+        
         // Remember the score at its rank
         scores.emplace_back(alignments[alignment_num].score());
         
@@ -658,10 +820,12 @@ vector<Alignment> MinimizerMapper::map(Alignment& aln) {
     double escape_bonus = mapq < std::numeric_limits<int32_t>::max() ? 1.0 : 2.0;
     double mapq_explored_cap = escape_bonus * faster_cap(minimizers, explored_minimizers, aln.sequence(), aln.quality());
 
-    // Remember the uncapped MAPQ and the caps
-    set_annotation(mappings.front(),"secondary_scores", scores);
-    set_annotation(mappings.front(), "mapq_uncapped", mapq);
-    set_annotation(mappings.front(), "mapq_explored_cap", mapq_explored_cap);
+    if (annotate_mappings) {
+        // Remember the uncapped MAPQ and the caps
+        set_annotation(mappings.front(),"secondary_scores", scores);
+        set_annotation(mappings.front(), "mapq_uncapped", mapq);
+        set_annotation(mappings.front(), "mapq_explored_cap", mapq_explored_cap);
+    }
 
     // Apply the caps and transformations
     mapq = round(min(mapq_explored_cap, min(mapq, 60.0)));
@@ -702,8 +866,8 @@ vector<Alignment> MinimizerMapper::map(Alignment& aln) {
         set_annotation(mappings[0], "param_score-fraction", (double) minimizer_score_fraction);
         set_annotation(mappings[0], "param_max-extensions", (double) max_extensions);
         set_annotation(mappings[0], "param_max-alignments", (double) max_alignments);
-        set_annotation(mappings[0], "param_cluster-score", (double) cluster_score_threshold);
-        set_annotation(mappings[0], "param_cluster-coverage", (double) cluster_coverage_threshold);
+        set_annotation(mappings[0], "param_cluster-score", score_threshold);
+        set_annotation(mappings[0], "param_cluster-coverage", coverage_threshold);
         set_annotation(mappings[0], "param_extension-set", (double) extension_set_score_threshold);
         set_annotation(mappings[0], "param_max-multimaps", (double) max_multimaps);
     }
@@ -752,6 +916,353 @@ vector<Alignment> MinimizerMapper::map(Alignment& aln) {
 
 //-----------------------------------------------------------------------------
 
+/// Append the given path to the end of another. If the appended path picks up
+/// on the same node right where the other one left off, its first mapping is
+/// merged into the last one.
+static void append_continuing_path(Path& path, Path&& suffix) {
+    for (int i = 0; i < suffix.mapping_size(); i++) {
+        Mapping& mapping = *suffix.mutable_mapping(i);
+        if (i == 0 && path.mapping_size() > 0) {
+            Mapping& last = *path.mutable_mapping(path.mapping_size() - 1);
+            if (last.position().node_id() == mapping.position().node_id() &&
+                last.position().is_reverse() == mapping.position().is_reverse() &&
+                last.position().offset() + mapping_from_length(last) == mapping.position().offset()) {
+                for (auto& edit : *mapping.mutable_edit()) {
+                    *last.add_edit() = std::move(edit);
+                }
+                continue;
+            }
+        }
+        *path.add_mapping() = std::move(mapping);
+    }
+}
+
+vector<size_t> MinimizerMapper::chain_colinear(const vector<ChainItem>& items, bool allow_overlap,
+                                               int32_t& best_score, int32_t& second_best_score) const {
+
+    best_score = 0;
+    second_best_score = 0;
+    if (items.empty()) {
+        return vector<size_t>();
+    }
+
+    const Aligner* aligner = this->get_regular_aligner();
+
+    // For each item, the score of the best chain ending there, the item before
+    // it in that chain, and the item that chain starts at.
+    vector<int32_t> chain_score(items.size());
+    vector<size_t> previous(items.size(), numeric_limits<size_t>::max());
+    vector<size_t> first(items.size());
+
+    for (size_t i = 0; i < items.size(); i++) {
+        const ChainItem& here = items[i];
+        chain_score[i] = here.score;
+        first[i] = i;
+        
+        size_t lookback_start = (i > this->max_chain_lookback ? i - this->max_chain_lookback : 0);
+        for (size_t j = lookback_start; j < i; j++) {
+            const ChainItem& there = items[j];
+            if (there.read_anchor >= here.read_anchor || there.read_start > here.read_start ||
+                there.read_end > here.read_end) {
+                // Not colinear in the read.
+                continue;
+            }
+            if (!allow_overlap && there.read_end > here.read_start) {
+                continue;
+            }
+            
+            int64_t graph_distance = this->distance_index.min_distance(there.graph_anchor, here.graph_anchor);
+            if (graph_distance < 0) {
+                continue;
+            }
+            int64_t read_distance = here.read_anchor - there.read_anchor;
+            int64_t indel = std::abs(graph_distance - read_distance);
+            if (indel > static_cast<int64_t>(this->max_chain_indel)) {
+                continue;
+            }
+            
+            // Only count the part of this item that the other one does not cover.
+            int32_t gain = here.score;
+            if (there.read_end > here.read_start) {
+                int32_t shared = there.read_end - here.read_start;
+                gain -= here.score * shared / static_cast<int32_t>(here.read_end - here.read_start);
+            }
+            int32_t penalty = (indel == 0 ? 0 : aligner->gap_open + (indel - 1) * aligner->gap_extension);
+            
+            int32_t candidate = chain_score[j] + gain - penalty;
+            if (candidate > chain_score[i]) {
+                chain_score[i] = candidate;
+                previous[i] = j;
+                first[i] = first[j];
+            }
+        }
+    }
+
+    size_t best_end = 0;
+    for (size_t i = 1; i < items.size(); i++) {
+        if (chain_score[i] > chain_score[best_end]) {
+            best_end = i;
+        }
+    }
+    best_score = chain_score[best_end];
+
+    // Any chain through an item of the best chain starts where the best chain
+    // starts, so the other chains are disjoint from it.
+    for (size_t i = 0; i < items.size(); i++) {
+        if (first[i] != first[best_end]) {
+            second_best_score = std::max(second_best_score, chain_score[i]);
+        }
+    }
+
+    vector<size_t> chain;
+    for (size_t i = best_end; i != numeric_limits<size_t>::max(); i = previous[i]) {
+        chain.push_back(i);
+    }
+    std::reverse(chain.begin(), chain.end());
+    return chain;
+}
+
+bool MinimizerMapper::map_long_read(Alignment& aln, vector<Alignment>& mappings) {
+
+    const string& sequence = aln.sequence();
+    const Aligner* aligner = this->get_regular_aligner();
+
+    Funnel funnel;
+    funnel.start(aln.name());
+    std::vector<Minimizer> minimizers = this->find_minimizers(sequence, funnel);
+    std::vector<Seed> seeds = this->find_seeds(minimizers, aln, funnel);
+
+    // Chain the seeds, measuring from the read base each seed is placed at.
+    vector<ChainItem> anchors;
+    anchors.reserve(seeds.size());
+    for (const Seed& seed : seeds) {
+        const Minimizer& minimizer = minimizers[seed.source];
+        anchors.push_back({ minimizer.forward_offset(), minimizer.forward_offset() + minimizer.length,
+                            minimizer.value.offset, seed.pos, minimizer.length * aligner->match });
+    }
+    std::sort(anchors.begin(), anchors.end(), [](const ChainItem& a, const ChainItem& b) {
+        return a.read_anchor < b.read_anchor;
+    });
+    int32_t seed_chain_score, seed_second_score;
+    vector<size_t> seed_chain = this->chain_colinear(anchors, true, seed_chain_score, seed_second_score);
+    if (seed_chain.empty()) {
+        return false;
+    }
+
+    // Extend the chained seeds.
+    GaplessExtender::cluster_type seed_matchings;
+    for (size_t anchor_num : seed_chain) {
+        seed_matchings.insert(GaplessExtender::to_seed(anchors[anchor_num].graph_anchor, anchors[anchor_num].read_anchor));
+    }
+    std::vector<GaplessExtension> extensions = this->extender.extend(seed_matchings, sequence);
+    if (extensions.empty()) {
+        return false;
+    }
+
+    // Chain the extensions, which may not overlap in the read.
+    vector<size_t> order(extensions.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return extensions[a].read_interval.first < extensions[b].read_interval.first;
+    });
+    vector<ChainItem> items;
+    items.reserve(extensions.size());
+    for (size_t extension_num : order) {
+        const GaplessExtension& extension = extensions[extension_num];
+        items.push_back({ extension.read_interval.first, extension.read_interval.second, extension.read_interval.first,
+                          make_pos_t(extension.starting_position(this->gbwt_graph)), extension.score });
+    }
+    int32_t chain_score, second_score;
+    vector<size_t> chain = this->chain_colinear(items, false, chain_score, second_score);
+
+    if (show_work) {
+        #pragma omp critical (cerr)
+        {
+            cerr << log_name() << "Chained " << seed_chain.size() << "/" << anchors.size() << " seeds into "
+                << chain.size() << "/" << extensions.size() << " extensions with score " << chain_score
+                << " (second best " << second_score << ")" << endl;
+        }
+    }
+
+    // Join the chained extensions with gap alignments. Give back a few bases
+    // on each side of each gap, so the gap alignment can place the indel.
+    Path middle;
+    size_t middle_end = 0;
+    size_t last_piece_length = 0;
+    for (size_t item_num : chain) {
+        const GaplessExtension& extension = extensions[order[item_num]];
+        Path piece = extension.to_path(this->gbwt_graph, sequence);
+        size_t piece_start = extension.read_interval.first;
+        size_t piece_length = extension.length();
+        if (middle.mapping_size() > 0) {
+            size_t left_trim = std::min(this->chain_gap_margin, last_piece_length - 1);
+            if (left_trim > 0) {
+                middle = cut_path(middle, path_to_length(middle) - left_trim).first;
+                middle_end -= left_trim;
+            }
+            size_t right_trim = std::min(this->chain_gap_margin, piece_length - 1);
+            if (right_trim > 0) {
+                piece = cut_path(piece, right_trim).second;
+                piece_start += right_trim;
+                piece_length -= right_trim;
+            }
+            
+            const Mapping& last = middle.mapping(middle.mapping_size() - 1);
+            pos_t from = make_pos_t(last.position().node_id(), last.position().is_reverse(),
+                                    last.position().offset() + mapping_from_length(last));
+            pos_t to = make_pos_t(piece.mapping(0).position());
+            Path gap;
+            if (!this->align_between(aln, middle_end, piece_start, from, to,
+                                     piece_start - middle_end + this->max_chain_indel, gap)) {
+                if (show_work) {
+                    #pragma omp critical (cerr)
+                    {
+                        cerr << log_name() << "Could not connect read interval " << middle_end << "-" << piece_start
+                            << " from " << from << " to " << to << endl;
+                    }
+                }
+                return false;
+            }
+            append_continuing_path(middle, std::move(gap));
+        }
+        append_continuing_path(middle, std::move(piece));
+        middle_end = extension.read_interval.second;
+        last_piece_length = piece_length;
+    }
+
+    // Align the tails off the ends of the chain.
+    Path left_tail;
+    const GaplessExtension& first_extension = extensions[order[chain.front()]];
+    if (!first_extension.left_full) {
+        size_t longest_detectable_gap;
+        auto forest = this->get_tail_forest(first_extension, sequence.size(), true, &longest_detectable_gap);
+        string before_sequence = sequence.substr(0, first_extension.read_interval.first);
+        left_tail = std::move(this->get_best_alignment_against_any_tree(forest, before_sequence,
+            first_extension.starting_position(this->gbwt_graph), false, longest_detectable_gap).first);
+    }
+    Path right_tail;
+    const GaplessExtension& last_extension = extensions[order[chain.back()]];
+    if (!last_extension.right_full) {
+        size_t longest_detectable_gap;
+        auto forest = this->get_tail_forest(last_extension, sequence.size(), false, &longest_detectable_gap);
+        string trailing_sequence = sequence.substr(last_extension.read_interval.second);
+        right_tail = std::move(this->get_best_alignment_against_any_tree(forest, trailing_sequence,
+            last_extension.tail_position(this->gbwt_graph), true, longest_detectable_gap).first);
+    }
+
+    // Create a new alignment object, without the old annotations.
+    Alignment mapped;
+    mapped.set_sequence(aln.sequence());
+    mapped.set_name(aln.name());
+    mapped.set_quality(aln.quality());
+    if (!sample_name.empty()) {
+        mapped.set_sample_name(sample_name);
+    }
+    if (!read_group.empty()) {
+        mapped.set_read_group(read_group);
+    }
+    Path& path = *mapped.mutable_path();
+    path = std::move(left_tail);
+    append_continuing_path(path, std::move(middle));
+    append_continuing_path(path, std::move(right_tail));
+    mapped.set_score(aligner->score_contiguous_alignment(mapped));
+    mapped.set_identity(identity(path));
+
+    // The chain has to beat the best chain it shares nothing with.
+    vector<double> scores { static_cast<double>(chain_score), static_cast<double>(std::max(second_score, 0)) };
+    double mapq = aligner->compute_mapping_quality(scores, false);
+    mapped.set_mapping_quality(max(min(mapq, 60.0), 0.0));
+    if (this->annotate_mappings) {
+        set_annotation(mapped, "chain_score", static_cast<double>(chain_score));
+        set_annotation(mapped, "second_chain_score", static_cast<double>(second_score));
+        set_annotation(mapped, "chained_seeds", static_cast<double>(seed_chain.size()));
+        set_annotation(mapped, "chained_extensions", static_cast<double>(chain.size()));
+    }
+
+    mappings.clear();
+    mappings.emplace_back(std::move(mapped));
+    return true;
+}
+
+bool MinimizerMapper::align_between(const Alignment& aln, size_t read_from, size_t read_to, pos_t from, pos_t to,
+                                    size_t max_length, Path& out) const {
+
+    out.Clear();
+    if (read_from == read_to && from == to) {
+        // Nothing to align.
+        return true;
+    }
+
+    // Both strands of each node become forward nodes in the strand-split
+    // graph, with the orientation in the low bit of the ID.
+    StrandSplitGraph split_graph(&this->gbwt_graph);
+    auto to_split = [](const pos_t& pos) {
+        return make_pos_t((id(pos) << 1) | (is_rev(pos) ? 1 : 0), false, offset(pos));
+    };
+    pos_t split_from = to_split(from);
+
+    bdsg::HashGraph connecting_graph;
+    unordered_map<id_t, id_t> connect_trans = algorithms::extract_connecting_graph(&split_graph, &connecting_graph,
+                                                                                  max_length, split_from, to_split(to),
+                                                                                  false);
+    if (connecting_graph.get_node_count() == 0) {
+        return false;
+    }
+    if (!handlealgs::is_directed_acyclic(&connecting_graph)) {
+        // Unroll cycles, at least as far as the gap could go.
+        bdsg::HashGraph dagified;
+        unordered_map<id_t, id_t> dagify_trans = handlealgs::dagify(&connecting_graph, &dagified, max_length);
+        for (auto& translation : dagify_trans) {
+            translation.second = connect_trans.at(translation.second);
+        }
+        connecting_graph = std::move(dagified);
+        connect_trans = std::move(dagify_trans);
+    }
+
+    Alignment gap;
+    gap.set_sequence(aln.sequence().substr(read_from, read_to - read_from));
+    if (!aln.quality().empty()) {
+        gap.set_quality(aln.quality().substr(read_from, read_to - read_from));
+    }
+    this->get_regular_aligner()->align_global_banded(gap, connecting_graph, this->chain_gap_band_padding, true);
+    out = std::move(*gap.mutable_path());
+
+    // Get rid of empty mappings on the cut ends of the nodes.
+    if (out.mapping_size() > 0) {
+        const Mapping& last = out.mapping(out.mapping_size() - 1);
+        if (mapping_from_length(last) == 0 && mapping_to_length(last) == 0) {
+            out.mutable_mapping()->RemoveLast();
+        }
+    }
+    if (out.mapping_size() > 0) {
+        const Mapping& first = out.mapping(0);
+        if (mapping_from_length(first) == 0 && mapping_to_length(first) == 0) {
+            out.mutable_mapping()->erase(out.mutable_mapping()->begin());
+        }
+    }
+    if (out.mapping_size() == 0) {
+        return true;
+    }
+
+    // Go back to the strand-split graph, where the first node was cut at the
+    // starting position, and then to the original graph.
+    translate_node_ids(out, connect_trans);
+    Position* first_position = out.mutable_mapping(0)->mutable_position();
+    if (first_position->node_id() == id(split_from)) {
+        first_position->set_offset(offset(split_from));
+    }
+    for (auto& mapping : *out.mutable_mapping()) {
+        Position* position = mapping.mutable_position();
+        id_t split_id = position->node_id();
+        position->set_node_id(split_id >> 1);
+        position->set_is_reverse((split_id & 1) != 0);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
 void MinimizerMapper::pair_all(pair<vector<Alignment>, vector<Alignment>>& mappings) const {
     if (!mappings.first.empty()) {
         for (auto& next : mappings.second) {
@@ -1651,8 +2162,10 @@ pair<vector<Alignment>, vector<Alignment>> MinimizerMapper::map_paired(Alignment
                     best_aln2.set_identity(0);
                     best_aln2.set_mapping_quality(0);
                 }
-                set_annotation(best_aln1, "unpaired", true);
-                set_annotation(best_aln2, "unpaired", true);
+                if (annotate_mappings) {
+                    set_annotation(best_aln1, "unpaired", true);
+                    set_annotation(best_aln2, "unpaired", true);
+                }
 
                 pair<vector<Alignment>, vector<Alignment>> paired_mappings;
                 paired_mappings.first.emplace_back(std::move(best_aln1));
@@ -1728,10 +2241,12 @@ pair<vector<Alignment>, vector<Alignment>> MinimizerMapper::map_paired(Alignment
 
                     double score = score_alignment_pair(mapped_aln, rescued_aln, fragment_dist);
 
-                    set_annotation(mapped_aln, "rescuer", true);
-                    set_annotation(rescued_aln, "rescued", true);
-                    set_annotation(mapped_aln,  "fragment_length", (double)fragment_dist);
-                    set_annotation(rescued_aln, "fragment_length", (double)fragment_dist);
+                    if (annotate_mappings) {
+                        set_annotation(mapped_aln, "rescuer", true);
+                        set_annotation(rescued_aln, "rescued", true);
+                        set_annotation(mapped_aln,  "fragment_length", (double)fragment_dist);
+                        set_annotation(rescued_aln, "fragment_length", (double)fragment_dist);
+                    }
 
                     //Since we're still accumulating a list of indexes of pairs of alignments,
                     //add the new alignment to the list of alignments 
@@ -2027,10 +2542,12 @@ pair<vector<Alignment>, vector<Alignment>> MinimizerMapper::map_paired(Alignment
 
             mapq_explored_caps[read_num] = mapq_explored_cap;
 
-            // Remember the caps
-            auto& to_annotate = (read_num == 0 ? mappings.first : mappings.second).front();
-            set_annotation(to_annotate, "mapq_explored_cap", mapq_explored_cap);
-            set_annotation(to_annotate, "mapq_score_group", mapq_score_groups[read_num]);
+            if (annotate_mappings) {
+                // Remember the caps
+                auto& to_annotate = (read_num == 0 ? mappings.first : mappings.second).front();
+                set_annotation(to_annotate, "mapq_explored_cap", mapq_explored_cap);
+                set_annotation(to_annotate, "mapq_score_group", mapq_score_groups[read_num]);
+            }
         }
         
         // Have a function to transform interesting cap values to uncapped.
@@ -2055,11 +2572,13 @@ pair<vector<Alignment>, vector<Alignment>> MinimizerMapper::map_paired(Alignment
             // Find the MAPQ to cap
             double read_mapq = uncapped_mapq;
             
-            // Remember the uncapped MAPQ
             auto& to_annotate = (read_num == 0 ? mappings.first : mappings.second).front();
-            set_annotation(to_annotate, "mapq_uncapped", read_mapq);
-            // And the cap we actually applied (possibly from the pair partner)
-            set_annotation(to_annotate, "mapq_applied_cap", mapq_cap);
+            if (annotate_mappings) {
+                // Remember the uncapped MAPQ
+                set_annotation(to_annotate, "mapq_uncapped", read_mapq);
+                // And the cap we actually applied (possibly from the pair partner)
+                set_annotation(to_annotate, "mapq_applied_cap", mapq_cap);
+            }
 
             // Apply the cap, and limit to 0-60
             double capped_mapq = min(mapq_cap, read_mapq); 
@@ -2083,14 +2602,16 @@ pair<vector<Alignment>, vector<Alignment>> MinimizerMapper::map_paired(Alignment
             }
         }
         
-        //Annotate top pair with its fragment distance, fragment length distrubution, and secondary scores
-        set_annotation(mappings.first.front(), "fragment_length", (double) distances.front());
-        set_annotation(mappings.second.front(), "fragment_length", (double) distances.front());
-        string distribution = "-I " + to_string(fragment_length_distr.mean()) + " -D " + to_string(fragment_length_distr.std_dev());
-        set_annotation(mappings.first.front(),"fragment_length_distribution", distribution);
-        set_annotation(mappings.second.front(),"fragment_length_distribution", distribution);
-        set_annotation(mappings.first.front(),"secondary_scores", scores);
-        set_annotation(mappings.second.front(),"secondary_scores", scores);
+        if (annotate_mappings) {
+            //Annotate top pair with its fragment distance, fragment length distrubution, and secondary scores
+            set_annotation(mappings.first.front(), "fragment_length", (double) distances.front());
+            set_annotation(mappings.second.front(), "fragment_length", (double) distances.front());
+            string distribution = "-I " + to_string(fragment_length_distr.mean()) + " -D " + to_string(fragment_length_distr.std_dev());
+            set_annotation(mappings.first.front(),"fragment_length_distribution", distribution);
+            set_annotation(mappings.second.front(),"fragment_length_distribution", distribution);
+            set_annotation(mappings.first.front(),"secondary_scores", scores);
+            set_annotation(mappings.second.front(),"secondary_scores", scores);
+        }
     
     }
     
@@ -2396,18 +2917,44 @@ double MinimizerMapper::get_log10_prob_of_disruption_in_interval(const vector<Mi
         return 0;
     }
    
+    // Work out the probability of disruption in every column at once. Each
+    // column starts with its base error probability, and is then multiplied
+    // by the probability of beating each disrupted minimizer that it flanks,
+    // in the same order as get_prob_of_disruption_in_column() would use, so
+    // the result is exactly the same. Going minimizer by minimizer lets each
+    // pass run over a contiguous range of columns.
+    thread_local vector<double> column_probs;
+    column_probs.resize(right - left);
+    for (size_t i = left; i < right; i++) {
+        column_probs[i - left] = phred_to_prob((uint8_t)quality_bytes[i]);
+    }
+    for (auto it = disrupt_begin; it != disrupt_end; ++it) {
+        auto& m = minimizers[*it];
+        size_t core_start = m.forward_offset();
+        size_t core_end = core_start + m.length;
+        size_t agglomeration_end = m.agglomeration_start + m.agglomeration_length;
+        // Columns in the minimizer itself aren't affected, so visit the flanks on either side.
+        for (auto flank : {make_pair(left, min(right, core_start)), make_pair(max(left, core_end), right)}) {
+            for (size_t i = flank.first; i < flank.second; i++) {
+                size_t possible_minimizers = min((size_t) m.length,
+                                                 min(i - m.agglomeration_start + 1, agglomeration_end - i));
+                column_probs[i - left] *= prob_for_at_least_one(m.value.hash, possible_minimizers);
+            }
+        }
+    }
+
     // We want an OR over all the columns, but some of the probabilities are tiny.
     // So instead of NOT(AND(NOT())), which also would assume independence the
     // way we calculate AND by multiplication, we just assume independence and
     // compute OR as (p1 + p2 - (p1 * p2)).
     // Start with the first column.
-    double p = get_prob_of_disruption_in_column(minimizers, sequence, quality_bytes, disrupt_begin, disrupt_end, left);
+    double p = column_probs[0];
 #ifdef debug
     cerr << "\tProbability disrupted at column " << left << ": " << p << endl;
 #endif
     for(size_t i = left + 1 ; i < right; i++) {
         // OR up probability of all the other columns
-        double col_p = get_prob_of_disruption_in_column(minimizers, sequence, quality_bytes, disrupt_begin, disrupt_end, i);
+        double col_p = column_probs[i - left];
 #ifdef debug
         cerr << "\tProbability disrupted at column " << i << ": " << col_p << endl;
 #endif
@@ -2497,24 +3044,13 @@ void MinimizerMapper::attempt_rescue(const Alignment& aligned_read, Alignment& r
     std::unordered_set<id_t> rescue_nodes;
     int64_t min_distance = max(0.0, fragment_length_distr.mean() - rescued_alignment.sequence().size() - rescue_subgraph_stdevs * fragment_length_distr.std_dev());
     int64_t max_distance = fragment_length_distr.mean() + rescue_subgraph_stdevs * fragment_length_distr.std_dev();
-    distance_index.subgraph_in_range(aligned_read.path(), &cached_graph, min_distance, max_distance, rescue_nodes, rescue_forward);
+    this->extract_rescue_subgraph(aligned_read.path(), cached_graph, min_distance, max_distance, rescue_forward, rescue_nodes);
 
     if (rescue_nodes.size() == 0) {
         //If the rescue subgraph is empty
         return;
     }
 
-    // Remove node ids that do not exist in the GBWTGraph from the subgraph.
-    // We may be using the distance index of the original graph, and nodes
-    // not visited by any thread are missing from the GBWTGraph.
-    for (auto iter = rescue_nodes.begin(); iter != rescue_nodes.end(); ) {
-        if (!cached_graph.has_node(*iter)) {
-            iter = rescue_nodes.erase(iter);
-        } else {
-            ++iter;
-        }
-    }
-
     // Get rid of the old path.
     rescued_alignment.clear_path();
 
@@ -2627,6 +3163,67 @@ void MinimizerMapper::attempt_rescue(const Alignment& aligned_read, Alignment& r
     }
 }
 
+void MinimizerMapper::extract_rescue_subgraph(const Path& path, const HandleGraph& graph, int64_t min_distance,
+                                              int64_t max_distance, bool rescue_forward,
+                                              std::unordered_set<id_t>& rescue_nodes) {
+
+    // Remove node ids that do not exist in the GBWTGraph from the subgraph.
+    // We may be using the distance index of the original graph, and nodes
+    // not visited by any thread are missing from the GBWTGraph.
+    auto remove_missing_nodes = [&](std::unordered_set<id_t>& nodes) {
+        for (auto iter = nodes.begin(); iter != nodes.end(); ) {
+            if (!graph.has_node(*iter)) {
+                iter = nodes.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    };
+
+    if (this->rescue_subgraph_cache_size == 0 || this->rescue_subgraph_window == 0 || path.mapping_size() == 0) {
+        distance_index.subgraph_in_range(path, &graph, min_distance, max_distance, rescue_nodes, rescue_forward);
+        remove_missing_nodes(rescue_nodes);
+        return;
+    }
+
+    // The search only depends on the position it starts from. Move that to
+    // the start of its window, and widen the range so that it covers a
+    // search from anywhere in the window.
+    pos_t start = rescue_forward ? initial_position(path) : final_position(path);
+    size_t window = offset(start) / this->rescue_subgraph_window;
+    int64_t window_min = std::max<int64_t>(0, min_distance - (int64_t) this->rescue_subgraph_window);
+    int64_t window_max = max_distance + this->rescue_subgraph_window;
+    RescueSubgraphCache::key_type key(id(start), is_rev(start), window, window_min, window_max);
+
+    RescueSubgraphCache::Shard& shard = this->rescue_subgraph_cache.shards[
+        std::hash<RescueSubgraphCache::key_type>()(key) % RescueSubgraphCache::SHARD_COUNT];
+    {
+        lock_guard<mutex> lock(shard.lock);
+        auto found = shard.subgraphs.find(key);
+        if (found != shard.subgraphs.end()) {
+            rescue_nodes = found->second;
+            return;
+        }
+    }
+
+    // Search from the start of the window with a single empty mapping, which
+    // starts and ends there.
+    Path window_path;
+    Position* window_pos = window_path.add_mapping()->mutable_position();
+    window_pos->set_node_id(id(start));
+    window_pos->set_offset(window * this->rescue_subgraph_window);
+    window_pos->set_is_reverse(is_rev(start));
+    distance_index.subgraph_in_range(window_path, &graph, window_min, window_max, rescue_nodes, rescue_forward);
+    remove_missing_nodes(rescue_nodes);
+
+    lock_guard<mutex> lock(shard.lock);
+    if (shard.subgraphs.size() * RescueSubgraphCache::SHARD_COUNT >= this->rescue_subgraph_cache_size) {
+        // Start over rather than track which subgraphs were used most recently.
+        shard.subgraphs.clear();
+    }
+    shard.subgraphs.emplace(key, rescue_nodes);
+}
+
 GaplessExtender::cluster_type MinimizerMapper::seeds_in_subgraph(const std::vector<Minimizer>& minimizers,
                                                                  const std::unordered_set<id_t>& subgraph) const {
     std::vector<id_t> sorted_ids(subgraph.begin(), subgraph.end());
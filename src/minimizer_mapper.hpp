@@ -20,7 +20,9 @@
 #include <gbwtgraph/minimizer.h>
 #include <structures/immutable_list.hpp>
 
+#include <array>
 #include <atomic>
+#include <mutex>
 
 namespace vg {
 
@@ -60,7 +62,9 @@ public:
      * oriented towards each other in the graph.
      *
      * If the reads are ambiguous and there's no fragment length distribution
-     * fixed yet, they will be dropped into ambiguous_pair_buffer.
+     * fixed yet, they will be dropped into ambiguous_pair_buffer. Threads
+     * may call this concurrently, each with its own buffer, while the
+     * distribution is being learned.
      *
      * Otherwise, at least one result will be returned for them (although it
      * may be the unmapped alignment).
@@ -146,6 +150,63 @@ public:
     /// If set, log what the mapper is thinking in its mapping of each read.
     bool show_work = false;
 
+    /// If false, skip the annotations that only describe how the mapping was
+    /// made (MAPQ components, secondary scores, fragment lengths, rescue
+    /// status). Output formats like GAF do not carry them, so there is no
+    /// need to build them.
+    bool annotate_mappings = true;
+
+    /// If nonzero, map this many single-ended reads with the fixed cluster
+    /// score and coverage thresholds while learning how far below the best
+    /// cluster the cluster that produces the winning alignment can be. The
+    /// rest of the reads are then mapped with the thresholds tightened to
+    /// that margin. Leave this at 0 when mapping pairs: map_paired() maps
+    /// the ends with map() until it knows the fragment length distribution.
+    size_t adaptive_cluster_training_reads = 0;
+
+    /// What fraction of training reads must have had their winning cluster
+    /// within the learned margins?
+    double adaptive_cluster_quantile = 0.999;
+
+    /// How much to add to the learned cluster score margin.
+    double adaptive_cluster_score_slack = 5;
+
+    /// How much to add to the learned cluster coverage margin.
+    double adaptive_cluster_coverage_slack = 0.05;
+
+    /// After training, also map every this-many-th read with the fixed
+    /// thresholds, to measure how often the learned thresholds change the
+    /// primary alignment. 0 to never check.
+    size_t adaptive_cluster_audit_interval = 1000;
+
+    /**
+     * Describe the learned cluster thresholds, the speed of mapping with the
+     * fixed and learned thresholds, and their concordance.
+     */
+    void report_adaptive_clusters(ostream& out) const;
+
+    /// If set, map single-ended reads by chaining their seeds colinearly
+    /// along the read and the graph, instead of clustering them. This suits
+    /// long reads, where clusters are too coarse and the gapless extensions
+    /// need to be joined by gapped alignments. Reads that cannot be chained
+    /// are mapped the usual way, as are all reads if do_dp is off.
+    bool long_read_chaining = false;
+
+    /// When chaining, how many preceding seeds in read order can each seed
+    /// be chained to?
+    size_t max_chain_lookback = 64;
+
+    /// When chaining, how different can the read and graph distances between
+    /// consecutive chained items be?
+    size_t max_chain_indel = 500;
+
+    /// How many bases to give back from each side of a gap between chained
+    /// extensions, so that the gap alignment can place the indel freely.
+    size_t chain_gap_margin = 8;
+
+    /// Band padding for aligning the read between chained extensions.
+    int32_t chain_gap_band_padding = 8;
+
     ////How many stdevs from fragment length distr mean do we cluster together?
     double paired_distance_stdevs = 2.0; 
 
@@ -167,10 +228,19 @@ public:
     /// The algorithm used for rescue.
     RescueAlgorithm rescue_algorithm = rescue_dozeu;
 
+    /// How many rescue subgraphs should we keep around for reuse? 0 to
+    /// extract a new subgraph for every rescue.
+    size_t rescue_subgraph_cache_size = 0;
+
+    /// When caching, rescues from mates that start on the same node and
+    /// strand within a window of this many bases share a subgraph. The shared
+    /// subgraph covers the distance range from anywhere in the window.
+    size_t rescue_subgraph_window = 32;
+
     bool fragment_distr_is_finalized () {return fragment_length_distr.is_finalized();}
     void finalize_fragment_length_distr() {
         if (!fragment_length_distr.is_finalized()) {
-            fragment_length_distr.force_parameters(fragment_length_distr.mean(), fragment_length_distr.std_dev());
+            fragment_length_distr.finalize();
         } 
     }
     void force_fragment_length_distr(double mean, double stdev) {
@@ -253,10 +323,107 @@ protected:
     FragmentLengthDistribution fragment_length_distr;
     atomic_flag warned_about_bad_distribution = ATOMIC_FLAG_INIT;
 
+    /// What we know about the winning clusters, for adaptive cluster thresholds.
+    struct AdaptiveClusterState {
+        /// Protects the training observations and the learned thresholds while training.
+        mutex training_mutex;
+        /// How far below the best score and coverage the winning cluster was, for each training read.
+        vector<double> score_margins;
+        vector<double> coverage_margins;
+        /// How many training reads have been mapped?
+        size_t training_reads = 0;
+        /// Set once the thresholds are learned, after which they don't change.
+        atomic<bool> trained{false};
+        double score_threshold = 0;
+        double coverage_threshold = 0;
+        /// Reads mapped with the learned thresholds, and how many of them were also mapped with the fixed ones.
+        atomic<size_t> pruned_reads{0};
+        atomic<size_t> audited_reads{0};
+        atomic<size_t> concordant_reads{0};
+        /// Total time spent mapping in each phase, in nanoseconds, for speed reporting.
+        atomic<size_t> training_nanoseconds{0};
+        atomic<size_t> pruned_nanoseconds{0};
+    };
+    AdaptiveClusterState adaptive_clusters;
+
+    /// Rescue subgraphs we have already extracted, sharded to keep threads
+    /// from waiting on each other.
+    struct RescueSubgraphCache {
+        /// Node, strand, offset window, and distance range of the search.
+        typedef tuple<id_t, bool, size_t, int64_t, int64_t> key_type;
+        struct Shard {
+            mutex lock;
+            unordered_map<key_type, std::unordered_set<id_t>> subgraphs;
+        };
+        constexpr static size_t SHARD_COUNT = 64;
+        array<Shard, SHARD_COUNT> shards;
+    };
+    RescueSubgraphCache rescue_subgraph_cache;
+
 //-----------------------------------------------------------------------------
 
     // Stages of mapping.
 
+    /**
+     * Map the given read with the given cluster score and coverage
+     * thresholds. If winner_margins is set, fill it in with how far below
+     * the best cluster score and coverage the cluster that produced the
+     * primary alignment was, or leave it alone if there was no such cluster.
+     */
+    vector<Alignment> map_with_cluster_thresholds(Alignment& aln, double score_threshold, double coverage_threshold,
+                                                  pair<double, double>* winner_margins);
+
+    /**
+     * Record the margins of the winning cluster for a training read, and
+     * learn the thresholds once there are enough reads.
+     */
+    void observe_adaptive_clusters(const pair<double, double>& winner_margins, bool has_winner, size_t nanoseconds);
+
+    /**
+     * Something that can be chained: a seed hit or a gapless extension.
+     * Read and graph distances between items are measured from read_anchor
+     * to graph_anchor, the graph position of that read base.
+     */
+    struct ChainItem {
+        size_t read_start;
+        size_t read_end;
+        size_t read_anchor;
+        pos_t graph_anchor;
+        int32_t score;
+    };
+
+    /**
+     * Find the best colinear chain of the given items, which must be sorted
+     * by read_anchor. Each item can follow one of the max_chain_lookback
+     * items before it, if it is reachable from it in the graph with an indel
+     * of at most max_chain_indel bp, which costs a gap penalty. If
+     * allow_overlap is set, items may overlap in the read and only the
+     * unshared part of an item's score is counted; otherwise they may not.
+     * Returns the item numbers of the chain in read order, and sets
+     * best_score and second_best_score to the score of that chain and of the
+     * best chain that shares no items with it.
+     */
+    vector<size_t> chain_colinear(const vector<ChainItem>& items, bool allow_overlap,
+                                  int32_t& best_score, int32_t& second_best_score) const;
+
+    /**
+     * Map the given single-ended read by chaining its seeds, extending the
+     * chain, and aligning between the chained extensions and off their
+     * ends. Returns false and leaves the read alone if no chain connects
+     * into a full alignment.
+     */
+    bool map_long_read(Alignment& aln, vector<Alignment>& mappings);
+
+    /**
+     * Globally align the given part of the read between graph position from,
+     * which is just past the end of the preceding aligned part, and graph
+     * position to, which starts the following aligned part, looking at
+     * walks at most max_length bp long. Returns false if there is no such
+     * walk.
+     */
+    bool align_between(const Alignment& aln, size_t read_from, size_t read_to, pos_t from, pos_t to,
+                       size_t max_length, Path& out) const;
+
     /**
      * Find the minimizers in the sequence using all minimizer indexes and
      * return them sorted in descending order by score.
@@ -302,6 +469,16 @@ protected:
      */
     void attempt_rescue(const Alignment& aligned_read, Alignment& rescued_alignment, const std::vector<Minimizer>& minimizers, bool rescue_forward);
 
+    /**
+     * Fill in rescue_nodes with the nodes of the GBWTGraph within the given
+     * distance range of the start (if rescue_forward) or end of the given
+     * path. If rescue_subgraph_cache_size is set, reuse the subgraph for an
+     * earlier search from nearby, which may have a few more nodes than
+     * necessary.
+     */
+    void extract_rescue_subgraph(const Path& path, const HandleGraph& graph, int64_t min_distance, int64_t max_distance,
+                                 bool rescue_forward, std::unordered_set<id_t>& rescue_nodes);
+
     /**
      * Return the all non-redundant seeds in the subgraph, including those from
      * minimizers not used for mapping.
@@ -10,6 +10,9 @@ namespace vg {
 
 const int Packer::maximum_quality = 60;
 const int Packer::lru_cache_size = 4096;
+const size_t Packer::default_nodes_per_chunk = 65536;
+// "VGPACKCH" (as a little-endian integer)
+const size_t Packer::chunked_magic = 0x484343414b504756;
 
 size_t Packer::estimate_data_width(size_t expected_coverage) {
     return std::ceil(std::log2(2 * expected_coverage));
@@ -156,6 +159,10 @@ void Packer::save_to_file(const string& file_name) {
 
 void Packer::load(istream& in) {
     sdsl::read_member(bin_size, in);
+    if (bin_size == chunked_magic) {
+        load_chunked(in, nullptr);
+        return;
+    }
     sdsl::read_member(n_bins, in);
     coverage_civ.load(in);
     edge_coverage_civ.load(in);
@@ -168,6 +175,146 @@ void Packer::load(istream& in) {
     is_compacted = true;
 }
 
+void Packer::load_from_file(const string& file_name, const vector<pair<nid_t, nid_t>>& id_ranges) {
+    ifstream in(file_name);
+    if (!in) {
+        stringstream ss;
+        ss << "Error [Packer]: unable to read pack file: \"" << file_name << "\"" << endl;
+        throw runtime_error(ss.str());
+    }
+    size_t magic;
+    sdsl::read_member(magic, in);
+    if (magic == chunked_magic) {
+        load_chunked(in, &id_ranges);
+    } else {
+        // no index to seek with, so load it all
+        in.clear();
+        in.seekg(0);
+        load(in);
+    }
+}
+
+void Packer::save_chunked_to_file(const string& file_name, size_t nodes_per_chunk) {
+    ofstream out(file_name);
+    serialize_chunked(out, nodes_per_chunk);
+}
+
+void Packer::load_chunked(istream& in, const vector<pair<nid_t, nid_t>>* id_ranges) {
+    size_t num_chunks;
+    sdsl::read_member(bin_size, in);
+    sdsl::read_member(n_bins, in);
+    sdsl::read_member(nodes_per_chunk, in);
+    sdsl::read_member(num_chunks, in);
+    sdsl::read_member(num_node_qualities_chunked, in);
+    edge_coverage_civ.load(in);
+    edit_csas.resize(n_bins);
+    for (size_t i = 0; i < n_bins; ++i) {
+        edit_csas[i].load(in);
+    }
+    chunk_base_starts.resize(num_chunks + 1);
+    for (size_t i = 0; i <= num_chunks; ++i) {
+        sdsl::read_member(chunk_base_starts[i], in);
+    }
+    vector<size_t> chunk_sizes(num_chunks);
+    for (size_t i = 0; i < num_chunks; ++i) {
+        sdsl::read_member(chunk_sizes[i], in);
+    }
+
+    // work out which chunks we need
+    chunk_loaded.assign(num_chunks, id_ranges == nullptr);
+    if (id_ranges != nullptr && graph->get_node_count() > 0) {
+        // Ranks need not follow IDs, so each node in a range has to be
+        // looked up. Ranges wider than the graph are checked with one scan
+        // over the nodes instead, so a sparse graph costs at most its size.
+        nid_t min_id = graph->min_node_id();
+        nid_t max_id = graph->max_node_id();
+        size_t node_count = graph->get_node_count();
+        vector<pair<nid_t, nid_t>> wide_ranges;
+        for (const pair<nid_t, nid_t>& id_range : *id_ranges) {
+            nid_t first = max(id_range.first, min_id);
+            nid_t last = min(id_range.second, max_id);
+            if (first > last) {
+                continue;
+            }
+            if ((size_t)(last - first) >= node_count) {
+                wide_ranges.emplace_back(first, last);
+                continue;
+            }
+            for (nid_t node_id = first; node_id <= last; ++node_id) {
+                size_t rank = node_index(node_id);
+                if (rank != 0) {
+                    chunk_loaded[rank / nodes_per_chunk] = true;
+                }
+            }
+        }
+        if (!wide_ranges.empty()) {
+            sort(wide_ranges.begin(), wide_ranges.end());
+            graph->for_each_handle([&](const handle_t& handle) {
+                nid_t node_id = graph->get_id(handle);
+                // find the last range starting at or before the node
+                auto it = upper_bound(wide_ranges.begin(), wide_ranges.end(), make_pair(node_id, numeric_limits<nid_t>::max()));
+                if (it != wide_ranges.begin() && (--it)->second >= node_id) {
+                    chunk_loaded[node_index(node_id) / nodes_per_chunk] = true;
+                }
+            });
+        }
+    }
+
+    coverage_chunks.clear();
+    coverage_chunks.resize(num_chunks);
+    node_quality_chunks.clear();
+    node_quality_chunks.resize(num_chunks);
+    for (size_t i = 0; i < num_chunks; ++i) {
+        if (chunk_loaded[i]) {
+            coverage_chunks[i].load(in);
+            node_quality_chunks[i].load(in);
+        } else {
+            in.seekg(chunk_sizes[i], ios_base::cur);
+        }
+    }
+    if (!in) {
+        throw runtime_error("Error [Packer]: unable to read chunked pack file");
+    }
+
+    if (id_ranges == nullptr) {
+        // stitch the chunks back together into the whole representation
+        int_vector<> coverage_iv(chunk_base_starts.back());
+        int_vector<> node_quality_iv(num_node_qualities_chunked);
+#pragma omp parallel for
+        for (size_t i = 0; i < num_chunks; ++i) {
+            for (size_t j = 0; j < coverage_chunks[i].size(); ++j) {
+                coverage_iv[chunk_base_starts[i] + j] = coverage_chunks[i][j];
+            }
+            for (size_t j = 0; j < node_quality_chunks[i].size(); ++j) {
+                node_quality_iv[i * nodes_per_chunk + j] = node_quality_chunks[i][j];
+            }
+        }
+        util::assign(coverage_civ, coverage_iv);
+        util::assign(node_quality_civ, node_quality_iv);
+        coverage_chunks.clear();
+        node_quality_chunks.clear();
+        chunk_loaded.clear();
+        chunk_base_starts.clear();
+        is_partial = false;
+    } else {
+        is_partial = true;
+    }
+    // We can only load compacted.
+    is_compacted = true;
+}
+
+bool Packer::is_partially_loaded(void) const {
+    return is_partial;
+}
+
+size_t Packer::chunk_of_position(size_t i) const {
+    return upper_bound(chunk_base_starts.begin(), chunk_base_starts.end(), i) - chunk_base_starts.begin() - 1;
+}
+
+bool Packer::has_coverage_at_position(size_t i) const {
+    return !is_partial || chunk_loaded[chunk_of_position(i)];
+}
+
 void Packer::merge_from_files(const vector<string>& file_names) {
 #ifdef debug
     cerr << "Merging " << file_names.size() << " pack files" << endl;
@@ -314,6 +461,66 @@ size_t Packer::serialize(std::ostream& out,
     return written;
 }
 
+size_t Packer::serialize_chunked(std::ostream& out, size_t nodes_per_chunk) {
+    make_compact();
+    assert(!is_partial);
+    const VectorizableHandleGraph* vec_graph = dynamic_cast<const VectorizableHandleGraph*>(graph);
+    assert(vec_graph != nullptr);
+    // chunks are over node ranks, counting the unused rank 0 so that qualities line up
+    size_t num_ranks = graph->get_node_count() + 1;
+    size_t num_chunks = (num_ranks + nodes_per_chunk - 1) / nodes_per_chunk;
+    vector<size_t> base_starts(num_chunks + 1);
+    for (size_t i = 0; i < num_chunks; ++i) {
+        size_t first_rank = max(i * nodes_per_chunk, (size_t)1);
+        base_starts[i] = first_rank < num_ranks ? vec_graph->node_vector_offset(vec_graph->rank_to_id(first_rank))
+            : coverage_civ.size();
+    }
+    base_starts[num_chunks] = coverage_civ.size();
+
+    // compress the chunks into memory first, so the index of their sizes can go in front of them
+    vector<string> chunks(num_chunks);
+#pragma omp parallel for
+    for (size_t i = 0; i < num_chunks; ++i) {
+        int_vector<> coverage_iv(base_starts[i + 1] - base_starts[i]);
+        for (size_t j = 0; j < coverage_iv.size(); ++j) {
+            coverage_iv[j] = coverage_civ[base_starts[i] + j];
+        }
+        size_t quality_start = min(i * nodes_per_chunk, node_quality_civ.size());
+        size_t quality_end = min((i + 1) * nodes_per_chunk, node_quality_civ.size());
+        int_vector<> node_quality_iv(quality_end - quality_start);
+        for (size_t j = 0; j < node_quality_iv.size(); ++j) {
+            node_quality_iv[j] = node_quality_civ[quality_start + j];
+        }
+        stringstream chunk_stream;
+        dac_vector<>(coverage_iv).serialize(chunk_stream);
+        vlc_vector<>(node_quality_iv).serialize(chunk_stream);
+        chunks[i] = chunk_stream.str();
+    }
+
+    size_t written = 0;
+    written += sdsl::write_member(chunked_magic, out);
+    written += sdsl::write_member(bin_size, out);
+    written += sdsl::write_member(edit_csas.size(), out);
+    written += sdsl::write_member(nodes_per_chunk, out);
+    written += sdsl::write_member(num_chunks, out);
+    written += sdsl::write_member(node_quality_civ.size(), out);
+    written += edge_coverage_civ.serialize(out);
+    for (auto& edit_csa : edit_csas) {
+        written += edit_csa.serialize(out);
+    }
+    for (size_t base_start : base_starts) {
+        written += sdsl::write_member(base_start, out);
+    }
+    for (const string& chunk : chunks) {
+        written += sdsl::write_member(chunk.size(), out);
+    }
+    for (const string& chunk : chunks) {
+        out.write(chunk.data(), chunk.size());
+        written += chunk.size();
+    }
+    return written;
+}
+
 void Packer::make_compact(void) {
     // pack the dynamic countarray and edit coverage into the compact data structure
     if (is_compacted) {
@@ -631,7 +838,9 @@ string Packer::unescape_delim(const string& s, char d) const {
 }
 
 size_t Packer::coverage_size(void) const {
-    if (is_compacted){
+    if (is_partial) {
+        return chunk_base_starts.back();
+    } else if (is_compacted){
         return coverage_civ.size();
     }
     else{
@@ -649,7 +858,9 @@ size_t Packer::edge_vector_size(void) const{
 }
 
 size_t Packer::node_quality_vector_size(void) const {
-    if (is_compacted) {
+    if (is_partial) {
+        return num_node_qualities_chunked;
+    } else if (is_compacted) {
         return node_quality_civ.size();
     } else {
         return num_nodes_dynamic;
@@ -771,7 +982,15 @@ void Packer::increment_node_quality(size_t i, size_t v) {
 }
 
 bool Packer::has_qualities() const {
-    if (is_compacted) {
+    if (is_partial) {
+        for (size_t i = 0; i < node_quality_chunks.size(); ++i) {
+            for (size_t j = 0; j < node_quality_chunks[i].size(); ++j) {
+                if (node_quality_chunks[i][j] > 0) {
+                    return true;
+                }
+            }
+        }
+    } else if (is_compacted) {
         for (size_t i = 0; i < node_quality_civ.size(); ++i) {
             if (node_quality_civ[i] > 0) {
                 return true;
@@ -792,7 +1011,11 @@ bool Packer::has_qualities() const {
 }
 
 size_t Packer::coverage_at_position(size_t i) const {
-    if (is_compacted) {
+    if (is_partial) {
+        size_t chunk = chunk_of_position(i);
+        assert(chunk_loaded[chunk]);
+        return coverage_chunks[chunk][i - chunk_base_starts[chunk]];
+    } else if (is_compacted) {
         return coverage_civ[i];
     } else {
         pair<size_t, size_t> bin_offset = coverage_bin_offset(i);
@@ -848,7 +1071,11 @@ size_t Packer::total_node_quality(size_t i) const {
 }
 
 size_t Packer::average_node_quality(size_t i) const {
-    if (is_compacted) {
+    if (is_partial) {
+        size_t chunk = i / nodes_per_chunk;
+        assert(chunk_loaded[chunk]);
+        return node_quality_chunks[chunk][i - chunk * nodes_per_chunk];
+    } else if (is_compacted) {
         return node_quality_civ[i];
     } else {
         Position pos;
@@ -937,13 +1164,19 @@ ostream& Packer::as_table(ostream& out, bool show_edits, vector<vg::id_t> node_i
     if (show_edits) out << "\t" << "edits";
     out << endl;
     // write the coverage as a vector
-    for (size_t i = 0; i < coverage_civ.size(); ++i) {
+    size_t num_positions = coverage_size();
+    for (size_t i = 0; i < num_positions; ++i) {
+        if (!has_coverage_at_position(i)) {
+            // only some chunks were loaded, so skip to the end of this one
+            i = chunk_base_starts[chunk_of_position(i) + 1] - 1;
+            continue;
+        }
         nid_t node_id = dynamic_cast<const VectorizableHandleGraph*>(graph)->node_at_vector_offset(i+1);
         if (!node_ids.empty() && find(node_ids.begin(), node_ids.end(), node_id) == node_ids.end()) {
             continue;
         }
         size_t offset = i - dynamic_cast<const VectorizableHandleGraph*>(graph)->node_vector_offset(node_id);
-        out << i << "\t" << node_id << "\t" << offset << "\t" << coverage_civ[i];
+        out << i << "\t" << node_id << "\t" << offset << "\t" << coverage_at_position(i);
         if (show_edits) {
             out << "\t" << count(edit_csas[bin_for_position(i)], pos_key(i));
             for (auto& edit : edits_at_position(i)) out << " " << pb2json(edit);
@@ -1077,5 +1310,309 @@ int Packer::combine_qualities(int map_quality, int base_quality) const {
     }
 }
 
-    
+
+Packers::Packers(const HandleGraph* graph) : graph(graph) {
+}
+
+void Packers::load(const vector<string>& file_names) {
+    this->file_names.insert(this->file_names.end(), file_names.begin(), file_names.end());
+}
+
+size_t Packers::size(void) const {
+    return file_names.size();
+}
+
+const vector<string>& Packers::get_file_names(void) const {
+    return file_names;
+}
+
+void Packers::for_each_packer(const function<void(size_t, const Packer&)>& iteratee,
+                              const vector<pair<nid_t, nid_t>>& id_ranges) const {
+    for (size_t i = 0; i < file_names.size(); ++i) {
+        // only one pack is ever in memory
+        Packer packer(graph);
+        if (id_ranges.empty()) {
+            packer.load_from_file(file_names[i]);
+        } else {
+            packer.load_from_file(file_names[i], id_ranges);
+        }
+        iteratee(i, packer);
+    }
+}
+
+const size_t CoverageMatrix::default_nodes_per_block = 1024;
+const size_t CoverageMatrix::default_edges_per_block = 4096;
+const size_t CoverageMatrix::default_max_buffered_values = 1 << 28;
+// "VGCOVMAT" (as a little-endian integer)
+const size_t CoverageMatrix::matrix_magic = 0x54414d564f434756;
+
+CoverageMatrix::CoverageMatrix(const HandleGraph* graph) : graph(graph) {
+}
+
+void CoverageMatrix::build(const Packers& packers, size_t nodes_per_block, size_t edges_per_block,
+                           size_t max_buffered_values) {
+    const VectorizableHandleGraph* vec_graph = dynamic_cast<const VectorizableHandleGraph*>(graph);
+    assert(vec_graph != nullptr);
+    this->nodes_per_block = nodes_per_block;
+    this->edges_per_block = edges_per_block;
+    num_samples = packers.size();
+
+    // lay out the node blocks in the base vector, counting the unused rank 0 like the chunked packs
+    size_t num_ranks = graph->get_node_count() + 1;
+    size_t num_blocks = (num_ranks + nodes_per_block - 1) / nodes_per_block;
+    size_t total_bases = 0;
+    graph->for_each_handle([&](const handle_t& handle) {
+            total_bases += graph->get_length(handle);
+        });
+    block_base_starts.resize(num_blocks + 1);
+    for (size_t i = 0; i < num_blocks; ++i) {
+        size_t first_rank = max(i * nodes_per_block, (size_t)1);
+        block_base_starts[i] = first_rank < num_ranks ? vec_graph->node_vector_offset(vec_graph->rank_to_id(first_rank))
+            : total_bases;
+    }
+    block_base_starts[num_blocks] = total_bases;
+
+    // size the edge vector the same way as the Packer
+    num_edges = 0;
+    graph->for_each_edge([&](const edge_t& edge) {
+            num_edges = max(num_edges, vec_graph->edge_index(edge));
+        });
+    ++num_edges;
+    size_t num_edge_blocks = (num_edges + edges_per_block - 1) / edges_per_block;
+
+    base_blocks.clear();
+    base_blocks.resize(num_blocks);
+    edge_blocks.clear();
+    edge_blocks.resize(num_edge_blocks);
+
+    // split the node blocks into passes that fit in the buffer
+    vector<size_t> pass_starts = {0};
+    size_t buffered = 0;
+    for (size_t i = 0; i < num_blocks; ++i) {
+        size_t block_values = (block_base_starts[i + 1] - block_base_starts[i]) * num_samples;
+        if (buffered > 0 && buffered + block_values > max_buffered_values) {
+            pass_starts.push_back(i);
+            buffered = 0;
+        }
+        buffered += block_values;
+    }
+    pass_starts.push_back(num_blocks);
+    size_t num_passes = pass_starts.size() - 1;
+
+    for (size_t pass = 0; pass < num_passes; ++pass) {
+        size_t first_block = pass_starts[pass];
+        size_t end_block = pass_starts[pass + 1];
+        // every pack is loaded in full for its edges anyway, so each pass takes a share of the edge blocks
+        size_t first_edge_block = num_edge_blocks * pass / num_passes;
+        size_t end_edge_block = num_edge_blocks * (pass + 1) / num_passes;
+
+        // the nodes of this pass, so that we only read the pack chunks we need
+        vector<pair<nid_t, nid_t>> id_ranges;
+        size_t end_rank = min(end_block * nodes_per_block, num_ranks);
+        for (size_t rank = max(first_block * nodes_per_block, (size_t)1); rank < end_rank; ++rank) {
+            nid_t node_id = vec_graph->rank_to_id(rank);
+            if (!id_ranges.empty() && id_ranges.back().second + 1 == node_id) {
+                id_ranges.back().second = node_id;
+            } else {
+                id_ranges.emplace_back(node_id, node_id);
+            }
+        }
+        if (id_ranges.empty()) {
+            // an empty range list would load everything
+            id_ranges.emplace_back(graph->min_node_id(), graph->min_node_id());
+        }
+
+        vector<int_vector<32>> base_buffers(end_block - first_block);
+        for (size_t i = first_block; i < end_block; ++i) {
+            base_buffers[i - first_block] = int_vector<32>((block_base_starts[i + 1] - block_base_starts[i]) * num_samples, 0);
+        }
+        vector<int_vector<32>> edge_buffers(end_edge_block - first_edge_block);
+        for (size_t i = first_edge_block; i < end_edge_block; ++i) {
+            size_t block_edges = min((i + 1) * edges_per_block, num_edges) - i * edges_per_block;
+            edge_buffers[i - first_edge_block] = int_vector<32>(block_edges * num_samples, 0);
+        }
+
+        packers.for_each_packer([&](size_t sample, const Packer& packer) {
+#pragma omp parallel for
+                for (size_t i = first_block; i < end_block; ++i) {
+                    int_vector<32>& buffer = base_buffers[i - first_block];
+                    size_t block_start = block_base_starts[i];
+                    for (size_t j = 0; j < buffer.size() / num_samples; ++j) {
+                        buffer[j * num_samples + sample] = packer.coverage_at_position(block_start + j);
+                    }
+                }
+                size_t packer_edges = packer.edge_vector_size();
+#pragma omp parallel for
+                for (size_t i = first_edge_block; i < end_edge_block; ++i) {
+                    int_vector<32>& buffer = edge_buffers[i - first_edge_block];
+                    size_t block_start = i * edges_per_block;
+                    for (size_t j = 0; j < buffer.size() / num_samples && block_start + j < packer_edges; ++j) {
+                        buffer[j * num_samples + sample] = packer.edge_coverage(block_start + j);
+                    }
+                }
+            }, id_ranges);
+
+#pragma omp parallel for
+        for (size_t i = first_block; i < end_block; ++i) {
+            util::assign(base_blocks[i], base_buffers[i - first_block]);
+            util::clear(base_buffers[i - first_block]);
+        }
+#pragma omp parallel for
+        for (size_t i = first_edge_block; i < end_edge_block; ++i) {
+            util::assign(edge_blocks[i], edge_buffers[i - first_edge_block]);
+            util::clear(edge_buffers[i - first_edge_block]);
+        }
+    }
+}
+
+size_t CoverageMatrix::sample_count(void) const {
+    return num_samples;
+}
+
+size_t CoverageMatrix::coverage_size(void) const {
+    return block_base_starts.empty() ? 0 : block_base_starts.back();
+}
+
+size_t CoverageMatrix::edge_vector_size(void) const {
+    return num_edges;
+}
+
+size_t CoverageMatrix::block_of_position(size_t i) const {
+    return upper_bound(block_base_starts.begin(), block_base_starts.end(), i) - block_base_starts.begin() - 1;
+}
+
+size_t CoverageMatrix::coverage_at_position(size_t i, size_t sample) const {
+    size_t block = block_of_position(i);
+    return base_blocks[block][(i - block_base_starts[block]) * num_samples + sample];
+}
+
+void CoverageMatrix::coverage_at_positions(size_t start, size_t end, vector<size_t>& coverage) const {
+    coverage.resize((end - start) * num_samples);
+    if (start >= end) {
+        return;
+    }
+    size_t block = block_of_position(start);
+    auto out = coverage.begin();
+    for (size_t i = start; i < end; ) {
+        // copy out the rest of the range that lies in this block
+        size_t block_end = min(end, block_base_starts[block + 1]);
+        const dac_vector<>& values = base_blocks[block];
+        for (size_t j = (i - block_base_starts[block]) * num_samples,
+                 k = (block_end - block_base_starts[block]) * num_samples; j < k; ++j, ++out) {
+            *out = values[j];
+        }
+        i = block_end;
+        ++block;
+    }
+}
+
+void CoverageMatrix::node_coverage(nid_t node_id, vector<size_t>& coverage) const {
+    size_t start = dynamic_cast<const VectorizableHandleGraph*>(graph)->node_vector_offset(node_id);
+    coverage_at_positions(start, start + graph->get_length(graph->get_handle(node_id)), coverage);
+}
+
+void CoverageMatrix::edge_coverage(size_t i, vector<size_t>& coverage) const {
+    size_t block = i / edges_per_block;
+    size_t offset = (i - block * edges_per_block) * num_samples;
+    coverage.resize(num_samples);
+    for (size_t j = 0; j < num_samples; ++j) {
+        coverage[j] = edge_blocks[block][offset + j];
+    }
+}
+
+void CoverageMatrix::save_to_file(const string& file_name) const {
+    ofstream out(file_name);
+    serialize(out);
+}
+
+void CoverageMatrix::load_from_file(const string& file_name) {
+    ifstream in(file_name);
+    if (!in) {
+        stringstream ss;
+        ss << "Error [CoverageMatrix]: unable to read coverage matrix file: \"" << file_name << "\"" << endl;
+        throw runtime_error(ss.str());
+    }
+    load(in);
+}
+
+size_t CoverageMatrix::serialize(ostream& out) const {
+    size_t written = 0;
+    written += sdsl::write_member(matrix_magic, out);
+    written += sdsl::write_member(num_samples, out);
+    written += sdsl::write_member(nodes_per_block, out);
+    written += sdsl::write_member(edges_per_block, out);
+    written += sdsl::write_member(num_edges, out);
+    written += sdsl::write_member(base_blocks.size(), out);
+    for (size_t base_start : block_base_starts) {
+        written += sdsl::write_member(base_start, out);
+    }
+    for (auto& base_block : base_blocks) {
+        written += base_block.serialize(out);
+    }
+    written += sdsl::write_member(edge_blocks.size(), out);
+    for (auto& edge_block : edge_blocks) {
+        written += edge_block.serialize(out);
+    }
+    return written;
+}
+
+void CoverageMatrix::load(istream& in) {
+    size_t magic;
+    sdsl::read_member(magic, in);
+    if (magic != matrix_magic) {
+        throw runtime_error("Error [CoverageMatrix]: input is not a coverage matrix");
+    }
+    size_t num_blocks;
+    sdsl::read_member(num_samples, in);
+    sdsl::read_member(nodes_per_block, in);
+    sdsl::read_member(edges_per_block, in);
+    sdsl::read_member(num_edges, in);
+    sdsl::read_member(num_blocks, in);
+    block_base_starts.resize(num_blocks + 1);
+    for (size_t i = 0; i <= num_blocks; ++i) {
+        sdsl::read_member(block_base_starts[i], in);
+    }
+    base_blocks.resize(num_blocks);
+    for (auto& base_block : base_blocks) {
+        base_block.load(in);
+    }
+    size_t num_edge_blocks;
+    sdsl::read_member(num_edge_blocks, in);
+    edge_blocks.resize(num_edge_blocks);
+    for (auto& edge_block : edge_blocks) {
+        edge_block.load(in);
+    }
+    if (!in) {
+        throw runtime_error("Error [CoverageMatrix]: unable to read coverage matrix");
+    }
+}
+
+ostream& CoverageMatrix::as_table(ostream& out, const vector<vg::id_t>& node_ids) const {
+    const VectorizableHandleGraph* vec_graph = dynamic_cast<const VectorizableHandleGraph*>(graph);
+    out << "seq.pos" << "\t"
+        << "node.id" << "\t"
+        << "node.offset";
+    for (size_t j = 0; j < num_samples; ++j) {
+        out << "\t" << "coverage." << j;
+    }
+    out << endl;
+    vector<size_t> coverage;
+    graph->for_each_handle([&](const handle_t& handle) {
+            nid_t node_id = graph->get_id(handle);
+            if (!node_ids.empty() && find(node_ids.begin(), node_ids.end(), node_id) == node_ids.end()) {
+                return;
+            }
+            size_t start = vec_graph->node_vector_offset(node_id);
+            node_coverage(node_id, coverage);
+            for (size_t i = 0; i < coverage.size() / max(num_samples, (size_t)1); ++i) {
+                out << start + i << "\t" << node_id << "\t" << i;
+                for (size_t j = 0; j < num_samples; ++j) {
+                    out << "\t" << coverage[i * num_samples + j];
+                }
+                out << endl;
+            }
+        });
+    return out;
+}
+
 }
@@ -61,10 +61,29 @@ public:
     void merge_from_dynamic(vector<Packer*>& packers);
     void load_from_file(const string& file_name);
     void save_to_file(const string& file_name);
+    /// Load packs in either the whole or the chunked format
     void load(istream& in);
     size_t serialize(std::ostream& out,
                      sdsl::structure_tree_node* s = NULL,
                      std::string name = "");
+
+    /// The default number of nodes per chunk in the chunked format
+    static const size_t default_nodes_per_chunk;
+    /// Write the packs in the chunked format, where the base coverage and node qualities are split
+    /// into independently stored chunks of node ranks, with an index of where each chunk is.
+    /// Requires the graph.
+    void save_chunked_to_file(const string& file_name, size_t nodes_per_chunk = default_nodes_per_chunk);
+    size_t serialize_chunked(std::ostream& out, size_t nodes_per_chunk = default_nodes_per_chunk);
+    /// Load only the chunks of a chunked pack file that contain the nodes in the given (inclusive) ID
+    /// ranges, seeking past the rest.  Edge coverage and edits are always loaded in full.  Base coverage
+    /// and node qualities can then only be queried for positions in the loaded chunks.  Requires the graph.
+    /// Packs in the whole format are loaded in full.
+    void load_from_file(const string& file_name, const vector<pair<nid_t, nid_t>>& id_ranges);
+    /// Is only part of the base coverage loaded?
+    bool is_partially_loaded(void) const;
+    /// Was the base coverage of the given position loaded?
+    bool has_coverage_at_position(size_t i) const;
+
     void make_compact(void);
     void make_dynamic(void);
     size_t position_in_basis(const Position& pos) const;
@@ -73,6 +92,8 @@ public:
     vector<Edit> edits_at_position(size_t i) const;
     size_t coverage_at_position(size_t i) const;
     void collect_coverage(const vector<Packer*>& packers);
+    /// Write the base coverage as a table. If only some node ranges were loaded, only
+    /// their positions are written.
     ostream& as_table(ostream& out, bool show_edits, vector<vg::id_t> node_ids);
     ostream& as_edge_table(ostream& out, vector<vg::id_t> node_ids);
     ostream& as_quality_table(ostream& out, vector<vg::id_t> node_ids);
@@ -175,6 +196,23 @@ private:
     vlc_vector<> node_quality_civ; // averge mapq for each node rank (compacted node_quality_dynamic)
     // edits
     vector<csa_sada<enc_vector<>, 32, 32, sa_order_sa_sampling<>, isa_sampling<>, succinct_byte_alphabet<> > > edit_csas;
+
+    // Identifies the chunked format.  The whole format starts with the bin size instead
+    static const size_t chunked_magic;
+    // load the chunked format after its magic number.  if id_ranges is null, all chunks are loaded
+    // into the whole representation above, otherwise only the chunks overlapping the ranges are loaded
+    void load_chunked(istream& in, const vector<pair<nid_t, nid_t>>* id_ranges);
+    // partially loaded model: chunk i holds node ranks [i * nodes_per_chunk, (i + 1) * nodes_per_chunk)
+    // and their bases [chunk_base_starts[i], chunk_base_starts[i + 1]).  chunks not loaded are empty
+    bool is_partial = false;
+    size_t nodes_per_chunk = 0;
+    size_t num_node_qualities_chunked = 0;
+    vector<size_t> chunk_base_starts;
+    vector<bool> chunk_loaded;
+    vector<dac_vector<>> coverage_chunks;
+    vector<vlc_vector<>> node_quality_chunks;
+    // chunk containing the base at the given position
+    size_t chunk_of_position(size_t i) const;
     // make separators that are somewhat unusual, as we escape these
     char delim1 = '\xff';
     char delim2 = '\xfe';
@@ -202,10 +240,81 @@ private:
     
 };
 
-// for making a combined matrix output and maybe doing other fun operations
-class Packers : public vector<Packer> {
+/// A set of pack files over the same graph, such as one per sample.  They are read one at a time,
+/// so that they never all need to be in memory at once.
+class Packers {
+public:
+    /// graph : Must implement the VectorizableHandleGraph interface
+    Packers(const HandleGraph* graph);
+    /// Add pack files to the set.  They are not read until they are used
     void load(const vector<string>& file_names);
-    ostream& as_table(ostream& out);
+    size_t size(void) const;
+    const vector<string>& get_file_names(void) const;
+    /// Load each pack in turn and pass it, along with its index in the set, to the callback.
+    /// If id_ranges are given, only the chunks of chunked packs that hold those nodes are read.
+    void for_each_packer(const function<void(size_t, const Packer&)>& iteratee,
+                         const vector<pair<nid_t, nid_t>>& id_ranges = {}) const;
+private:
+    const HandleGraph* graph;
+    vector<string> file_names;
+};
+
+/// The base and edge coverage of many samples over the same graph, stored node-major: each block
+/// of node ranks holds the coverage of its bases for every sample, with all the samples for a base
+/// adjacent, so the coverage of all samples over a node range is one contiguous read.  Edge coverage
+/// is laid out the same way in blocks of edge indexes.
+class CoverageMatrix {
+public:
+    static const size_t default_nodes_per_block;
+    static const size_t default_edges_per_block;
+    static const size_t default_max_buffered_values;
+
+    /// graph : Must implement the VectorizableHandleGraph interface
+    CoverageMatrix(const HandleGraph* graph);
+
+    /// Transpose the packs into the matrix, one sample per pack.  The packs are read in passes over
+    /// node ranges, buffering at most about max_buffered_values coverage values between passes.
+    /// Chunked packs (see Packer::save_chunked_to_file()) only need the chunks for each pass read.
+    void build(const Packers& packers, size_t nodes_per_block = default_nodes_per_block,
+               size_t edges_per_block = default_edges_per_block,
+               size_t max_buffered_values = default_max_buffered_values);
+
+    size_t sample_count(void) const;
+    size_t coverage_size(void) const;
+    size_t edge_vector_size(void) const;
+
+    /// Coverage of one sample at a position in the (forward) base vector
+    size_t coverage_at_position(size_t i, size_t sample) const;
+    /// Coverage of all samples for positions [start, end), as (end - start) rows of sample_count() values
+    void coverage_at_positions(size_t start, size_t end, vector<size_t>& coverage) const;
+    /// Coverage of all samples over the forward strand of a node, as above
+    void node_coverage(nid_t node_id, vector<size_t>& coverage) const;
+    /// Coverage of all samples for the given edge index (see Packer::edge_index())
+    void edge_coverage(size_t i, vector<size_t>& coverage) const;
+
+    void save_to_file(const string& file_name) const;
+    void load_from_file(const string& file_name);
+    size_t serialize(ostream& out) const;
+    void load(istream& in);
+    /// Write a table of base coverage, with a column for each sample
+    ostream& as_table(ostream& out, const vector<vg::id_t>& node_ids) const;
+
+private:
+    // Identifies the serialized matrix
+    static const size_t matrix_magic;
+    // block containing the base at the given position
+    size_t block_of_position(size_t i) const;
+
+    const HandleGraph* graph;
+    size_t num_samples = 0;
+    size_t nodes_per_block = 0;
+    size_t edges_per_block = 0;
+    size_t num_edges = 0;
+    // block i holds node ranks [i * nodes_per_block, (i + 1) * nodes_per_block), which are
+    // bases [block_base_starts[i], block_base_starts[i + 1])
+    vector<size_t> block_base_starts;
+    vector<dac_vector<>> base_blocks;
+    vector<dac_vector<>> edge_blocks;
 };
 
 }
@@ -36,6 +36,9 @@ QualAdjXdropAligner& QualAdjXdropAligner::operator=(const QualAdjXdropAligner& o
         if (dz) {
             dz_destroy(dz);
         }
+        if (query_dz) {
+            dz_destroy(query_dz);
+        }
         
         // TODO: a bit of an arcane step
         // we need to pull out the 0-padded quality adjusted matrices from dz into a contiguous array
@@ -48,8 +51,15 @@ QualAdjXdropAligner& QualAdjXdropAligner::operator=(const QualAdjXdropAligner& o
                               qual_adj_matrix,
                               *((const uint16_t*) &other.dz->giv),
                               *((const uint16_t*) &other.dz->gev));
+        query_dz = dz_qual_adj_init(other.dz->matrix,
+                                    qual_adj_matrix,
+                                    *((const uint16_t*) &other.dz->giv),
+                                    *((const uint16_t*) &other.dz->gev));
         
         free(qual_adj_matrix);
+        
+        // the other aligner's packed queries live in its own arena
+        num_cached_queries = 0;
     }
 
 	return *this;
@@ -68,6 +78,14 @@ QualAdjXdropAligner& QualAdjXdropAligner::operator=(QualAdjXdropAligner&& other)
         }
         dz = other.dz;
         other.dz = nullptr;
+        if (query_dz) {
+            dz_destroy(query_dz);
+        }
+        query_dz = other.query_dz;
+        other.query_dz = nullptr;
+        query_cache = std::move(other.query_cache);
+        num_cached_queries = other.num_cached_queries;
+        other.num_cached_queries = 0;
     }
 
 	return *this;
@@ -95,6 +113,8 @@ QualAdjXdropAligner::QualAdjXdropAligner(const int8_t* _score_matrix,
     
     dz = dz_qual_adj_init(_score_matrix, qual_adj_scores_4x4, _gap_open - _gap_extension,
                           _gap_extension);
+    query_dz = dz_qual_adj_init(_score_matrix, qual_adj_scores_4x4, _gap_open - _gap_extension,
+                                _gap_extension);
     
     free(qual_adj_scores_4x4);
 }
@@ -102,16 +122,17 @@ QualAdjXdropAligner::QualAdjXdropAligner(const int8_t* _score_matrix,
 QualAdjXdropAligner::~QualAdjXdropAligner(void)
 {
     dz_destroy(dz);
+    dz_destroy(query_dz);
 }
 
 dz_query_s* QualAdjXdropAligner::pack_query_forward(const char* seq, const uint8_t* qual,
                                                     int8_t full_length_bonus, size_t len) {
-    return dz_qual_adj_pack_query_forward(dz, seq, qual, full_length_bonus, len);
+    return dz_qual_adj_pack_query_forward(query_dz, seq, qual, full_length_bonus, len);
 }
 
 dz_query_s* QualAdjXdropAligner::pack_query_reverse(const char* seq, const uint8_t* qual,
                                                     int8_t full_length_bonus, size_t len) {
-    return dz_qual_adj_pack_query_reverse(dz, seq, qual, full_length_bonus, len);
+    return dz_qual_adj_pack_query_reverse(query_dz, seq, qual, full_length_bonus, len);
 }
 
 const dz_forefront_s* QualAdjXdropAligner::scan(const dz_query_s* query, const dz_forefront_s** forefronts,
@@ -134,6 +155,10 @@ void QualAdjXdropAligner::flush() {
     dz_qual_adj_flush(dz);
 }
 
+void QualAdjXdropAligner::flush_queries() {
+    dz_qual_adj_flush(query_dz);
+}
+
 /**
  * end of xdrop_aligner.cpp
  */
@@ -17,7 +17,9 @@
 #include "../vg.hpp"
 #include "xg.hpp"
 #include "../indexed_vg.hpp"
+#include "../memoizing_graph.hpp"
 #include "../algorithms/extract_connecting_graph.hpp"
+#include "../minimizer_mapper.hpp"
 
 
 
@@ -25,6 +27,13 @@ using namespace std;
 using namespace vg;
 using namespace vg::subcommand;
 
+/// Expose the MAPQ cap computation of the minimizer mapper to benchmark it.
+class BenchmarkMinimizerMapper : public MinimizerMapper {
+public:
+    using MinimizerMapper::Minimizer;
+    using MinimizerMapper::faster_cap;
+};
+
 void help_benchmark(char** argv) {
     cerr << "usage: " << argv[0] << " benchmark [options] >report.tsv" << endl
          << "options:" << endl
@@ -38,6 +47,9 @@ int main_benchmark(int argc, char** argv) {
     // Which experiments should we run?
     bool sort_and_order_experiment = false;
     bool get_sequence_experiment = true;
+    bool memoizing_graph_experiment = true;
+    bool mapq_cap_experiment = true;
+    bool xdrop_query_experiment = true;
     
     int c;
     optind = 2; // force optind past command positional argument
@@ -169,6 +181,97 @@ int main_benchmark(int argc, char** argv) {
         
     }
     
+    if (memoizing_graph_experiment) {
+        
+        // Look up each node several times, as the mappers do for a read
+        for (bool use_flat_memo : {false, true}) {
+            results.push_back(run_benchmark(string("MemoizingGraph::get_handle ") + (use_flat_memo ? "flat" : "hash"), 1000, [&]() {
+                MemoizingGraph memoizing_graph(&xg_index);
+                memoizing_graph.use_flat_memo = use_flat_memo;
+                for (size_t repeat = 0; repeat < 10; repeat++) {
+                    for (size_t i = 1; i < 101; i++) {
+                        handle_t handle = memoizing_graph.get_handle(i, repeat % 2);
+                        assert(memoizing_graph.get_id(handle) == i);
+                    }
+                }
+            }));
+            
+            results.push_back(run_benchmark(string("MemoizingGraph::steps_of_handle ") + (use_flat_memo ? "flat" : "hash"), 1000, [&]() {
+                MemoizingGraph memoizing_graph(&xg_index);
+                memoizing_graph.use_flat_memo = use_flat_memo;
+                for (size_t repeat = 0; repeat < 10; repeat++) {
+                    for (size_t i = 1; i < 101; i++) {
+                        auto steps = memoizing_graph.steps_of_handle(memoizing_graph.get_handle(i));
+                    }
+                }
+            }));
+        }
+        
+    }
+    
+    if (mapq_cap_experiment) {
+        
+        // Make a 250bp read covered in overlapping minimizers, all explored,
+        // as giraffe sees for a read in a repetitive region.
+        string sequence;
+        string quality;
+        for (size_t i = 0; i < 250; i++) {
+            sequence.push_back("ACGT"[(i * 7 + i / 3) % 4]);
+            quality.push_back((char)(10 + (i * 13) % 31));
+        }
+        int core_width = 29;
+        int flank_width = 11;
+        vector<BenchmarkMinimizerMapper::Minimizer> minimizers;
+        vector<size_t> minimizers_explored;
+        for (int core_start = 0; core_start + core_width <= sequence.size(); core_start += 4) {
+            minimizers_explored.push_back(minimizers.size());
+            minimizers.emplace_back();
+            BenchmarkMinimizerMapper::Minimizer& m = minimizers.back();
+            m.agglomeration_start = max(0, core_start - flank_width);
+            m.agglomeration_length = min<int>(sequence.size(), core_start + core_width + flank_width) - m.agglomeration_start;
+            m.value.key = gbwtgraph::DefaultMinimizerIndex::key_type::encode(sequence.substr(core_start, core_width));
+            m.value.hash = m.value.key.hash();
+            m.value.offset = core_start;
+            m.value.is_reverse = false;
+            m.hits = 1;
+            m.occs = nullptr;
+            m.length = core_width;
+            m.candidates_per_window = flank_width + 1;
+            m.score = 1;
+        }
+        
+        results.push_back(run_benchmark("MinimizerMapper::faster_cap", 1000, [&]() {
+            double cap = BenchmarkMinimizerMapper::faster_cap(minimizers, minimizers_explored, sequence, quality);
+            assert(!std::isinf(cap));
+        }));
+    }
+    
+    if (xdrop_query_experiment) {
+        
+        // Align tails against a 200bp node, as giraffe does against each tree
+        // in a tail's forest.
+        string reference;
+        for (size_t i = 0; i < 200; i++) {
+            reference.push_back("ACGT"[(i * 5 + i / 7) % 4]);
+        }
+        VG tail_graph;
+        tail_graph.create_node(reference);
+        Aligner aligner;
+        
+        // Either the same tail every time, whose packed query can be reused,
+        // or tails of different lengths, which need new packed queries.
+        for (bool same_tail : {true, false}) {
+            results.push_back(run_benchmark(string("XdropAligner::align_pinned ") + (same_tail ? "same tail" : "different tails"), 1000, [&]() {
+                for (size_t i = 0; i < 8; i++) {
+                    Alignment tail;
+                    tail.set_sequence(reference.substr(0, same_tail ? 150 : 150 - i));
+                    aligner.align_pinned(tail, tail_graph, true, true);
+                    assert(tail.score() > 0);
+                }
+            }));
+        }
+    }
+    
     // Do the control against itself
     results.push_back(run_benchmark("control", 1000, benchmark_control));
 
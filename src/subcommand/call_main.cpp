@@ -14,6 +14,7 @@
 #include "../path.hpp"
 #include "../graph_caller.hpp"
 #include "../integrated_snarl_finder.hpp"
+#include "../algorithms/coverage_depth.hpp"
 #include "../xg.hpp"
 #include <vg/io/stream.hpp>
 #include <vg/io/vpkg.hpp>
@@ -31,6 +32,7 @@ void help_call(char** argv) {
        << "    -k, --pack FILE          Supports created from vg pack for given input graph" << endl
        << "    -m, --min-support M,N    Minimum allele support (M) and minimum site support (N) for call [default = 1,4]" << endl
        << "    -e, --baseline-error X,Y Baseline error rates for Poisson model for small (X) and large (Y) variants [default= 0.005,0.001]" << endl
+       << "    -D, --depth-index FILE   Binned depth index written by vg pack -P with the same pack, to avoid recomputing it" << endl
        << "    -B, --bias-mode          Use old ratio-based genotyping algorithm as opposed to porbablistic model" << endl
        << "    -b, --het-bias M,N       Homozygous alt/ref allele must have >= M/N times more support than the next best allele [default = 6,6]" << endl
        << "GAF options:" << endl
@@ -49,6 +51,8 @@ void help_call(char** argv) {
        << "    -o, --ref-offset N      Offset in reference path (multiple allowed, 1 per path)" << endl
        << "    -l, --ref-length N      Override length of reference in the contig field of output VCF" << endl
        << "    -d, --ploidy N          Ploidy of sample.  Only 1 and 2 supported. (default: 2)" << endl
+       << "    -S, --spill-variants N  Buffer at most N variants per thread in memory, spilling sorted runs to" << endl
+       << "                            temporary files that are merged on output [default: keep all in memory]" << endl
        << "    -t, --threads N         number of threads to use" << endl;
 }    
 
@@ -74,13 +78,14 @@ int main_call(int argc, char** argv) {
     bool gaf_output = false;
     size_t trav_padding = 0;
     bool genotype_snarls = false;
+    size_t max_buffered_variants = 0;
 
     // constants
     const size_t avg_trav_threshold = 50;
     const size_t avg_node_threshold = 50;
-    const size_t min_depth_bin_width = 50;
-    const size_t max_depth_bin_width = 50000000;
-    const double depth_scale_fac = 1.5;
+    // defaults are shared with vg pack -P
+    const algorithms::BinnedDepthIndexParams depth_params;
+    string depth_index_filename;
     const size_t max_yens_traversals = traversals_only ? 100 : 50;
     // used to merge up snarls from chains when generating traversals
     const size_t max_chain_edges = 1000; 
@@ -111,6 +116,8 @@ int main_call(int argc, char** argv) {
             {"traversals", no_argument, 0, 'T'},
             {"min-trav-len", required_argument, 0, 'M'},
             {"legacy", no_argument, 0, 'L'},
+            {"spill-variants", required_argument, 0, 'S'},
+            {"depth-index", required_argument, 0, 'D'},
             {"threads", required_argument, 0, 't'},
             {"help", no_argument, 0, 'h'},
             {0, 0, 0, 0}
@@ -118,7 +125,7 @@ int main_call(int argc, char** argv) {
 
         int option_index = 0;
 
-        c = getopt_long (argc, argv, "k:Be:b:m:v:af:i:s:r:g:p:o:l:d:GTLM:t:h",
+        c = getopt_long (argc, argv, "k:Be:b:m:v:af:i:s:r:g:p:o:l:d:GTLM:S:D:t:h",
                          long_options, &option_index);
 
         // Detect the end of the options.
@@ -188,6 +195,12 @@ int main_call(int argc, char** argv) {
         case 'L':
             legacy = true;
             break;
+        case 'S':
+            max_buffered_variants = parse<size_t>(optarg);
+            break;
+        case 'D':
+            depth_index_filename = optarg;
+            break;
         case 't':
         {
             int num_threads = parse<int>(optarg);
@@ -370,8 +383,8 @@ int main_call(int argc, char** argv) {
         // Load our packed supports (they must have come from vg pack on graph)
         packer = unique_ptr<Packer>(new Packer(graph));
         packer->load_from_file(pack_filename);
-        // Make a packed traversal support finder (using cached veresion important for poisson caller)
-        PackedTraversalSupportFinder* packed_support_finder = new CachedPackedTraversalSupportFinder(*packer, *snarl_manager);
+        // Make a packed traversal support finder (precomputing node and edge supports is important for poisson caller)
+        PackedTraversalSupportFinder* packed_support_finder = new DensePackedTraversalSupportFinder(*packer, *snarl_manager);
         support_finder = unique_ptr<TraversalSupportFinder>(packed_support_finder);
         
         // need to use average support when genotyping as small differences in between sample and graph
@@ -383,9 +396,17 @@ int main_call(int argc, char** argv) {
         SupportBasedSnarlCaller* packed_caller = nullptr;
 
         if (ratio_caller == false) {
-            // Make a depth index
-            depth_index = algorithms::binned_packed_depth_index(*packer, ref_paths, min_depth_bin_width, max_depth_bin_width,
-                                                                depth_scale_fac, 0, true, true);
+            // Load or make a depth index
+            if (depth_index_filename.empty() ||
+                !algorithms::load_binned_depth_index(depth_index_filename, depth_params,
+                                                     algorithms::packed_coverage_fingerprint(*packer),
+                                                     ref_paths, depth_index)) {
+                if (!depth_index_filename.empty()) {
+                    cerr << "warning [vg call]: Depth index " << depth_index_filename << " does not match the "
+                         << "pack, reference paths or depth parameters; recomputing it" << endl;
+                }
+                depth_index = algorithms::binned_packed_depth_index(*packer, ref_paths, depth_params);
+            }
             // Make a new-stype probablistic caller
             auto poisson_caller = new PoissonSupportSnarlCaller(*graph, *snarl_manager, *packed_support_finder, depth_index,
                                                                 //todo: qualities need to be used better in conjunction with
@@ -507,6 +528,15 @@ int main_call(int argc, char** argv) {
         graph_caller = unique_ptr<GraphCaller>(flow_caller);
     }
 
+    string header;
+    if (!gaf_output) {
+        VCFOutputCaller* vcf_caller = dynamic_cast<VCFOutputCaller*>(graph_caller.get());
+        assert(vcf_caller != nullptr);
+        // The header has to exist before variants can be spilled to disk
+        header = vcf_caller->vcf_header(*graph, ref_paths, ref_path_lengths);
+        vcf_caller->set_max_buffered_variants(max_buffered_variants);
+    }
+
     // Call the graph
     if (!traversals_only) {
 
@@ -523,7 +553,7 @@ int main_call(int argc, char** argv) {
         // Output VCF
         VCFOutputCaller* vcf_caller = dynamic_cast<VCFOutputCaller*>(graph_caller.get());
         assert(vcf_caller != nullptr);
-        cout << vcf_caller->vcf_header(*graph, ref_paths, ref_path_lengths) << flush;
+        cout << header << flush;
         vcf_caller->write_variants(cout);
     }
     
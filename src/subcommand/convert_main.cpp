@@ -30,7 +30,8 @@ void help_convert(char** argv) {
          << "    -o, --odgi-out         output in ODGI format" << endl
          << "    -G, --gam-to-gaf FILE  convert GAM FILE to GAF" << endl
          << "    -F, --gaf-to-gam FILE  convert GAF FILE to GAM" << endl
-         << "    -t, --threads N        use N threads (defaults to numCPUs)" << endl;    
+         << "    -t, --threads N        use N threads (defaults to numCPUs)" << endl
+         << "    -P, --progress         show progress" << endl;    
 }
 
 int main_convert(int argc, char** argv) {
@@ -40,6 +41,7 @@ int main_convert(int argc, char** argv) {
     string input_aln;
     bool gam_to_gaf = false;
     bool gaf_to_gam = false;
+    bool show_progress = false;
 
     if (argc == 2) {
         help_convert(argv);
@@ -61,11 +63,12 @@ int main_convert(int argc, char** argv) {
             {"gam-to-gaf", required_argument, 0, 'G'},
             {"gaf-to-gam", required_argument, 0, 'F'},
             {"threads", required_argument, 0, 't'},
+            {"progress", no_argument, 0, 'P'},
             {0, 0, 0, 0}
 
         };
         int option_index = 0;
-        c = getopt_long (argc, argv, "hgvxapxoG:F:t:",
+        c = getopt_long (argc, argv, "hgvxapxoG:F:t:P",
                 long_options, &option_index);
 
         // Detect the end of the options.
@@ -115,6 +118,9 @@ int main_convert(int argc, char** argv) {
                 omp_set_num_threads(num_threads);
             }
             break;
+        case 'P':
+            show_progress = true;
+            break;
         default:
             abort();
         }
@@ -197,13 +203,14 @@ int main_convert(int argc, char** argv) {
                     MutablePathMutableHandleGraph* mutable_output_graph = dynamic_cast<MutablePathMutableHandleGraph*>(output_path_graph);
                     assert(mutable_output_graph != nullptr);
                     algorithms::gfa_to_path_handle_graph(input_stream_name, mutable_output_graph,
-                                                         input_stream_name != "-", output_format == "odgi");
+                                                         input_stream_name != "-", output_format == "odgi",
+                                                         show_progress);
                 }
                 else {
                     MutableHandleGraph* mutable_output_graph = dynamic_cast<MutableHandleGraph*>(output_graph.get());
                     assert(mutable_output_graph != nullptr);
                     algorithms::gfa_to_handle_graph(input_stream_name, mutable_output_graph,
-                                                    input_stream_name != "-", false);
+                                                    input_stream_name != "-", false, show_progress);
                 }
             } catch (algorithms::GFAFormatError& e) {
                 cerr << "error [vg convert]: Input GFA is not acceptable." << endl;
@@ -39,6 +39,9 @@ void help_depth(char** argv) {
          << "    -n, --max-nodes N      maximum nodes to consider [1000000]" << endl
          << "    -s, --random-seed N    random seed for sampling nodes to consider" << endl
          << "    -Q, --min-mapq N       ignore alignments with mapping quality < N [0]" << endl
+         << "    -i, --indexed          seek to sampled nodes in a sorted GAM with an index (FILE.gai) instead of reading it all" << endl
+         << "    -e, --precision X      with -i, stop sampling once the 95% confidence intervals on the mean and variance" << endl
+         << "                           are within X of the estimates (0 to always sample -n nodes) [0.02]" << endl
          << "  common options:" << endl
          << "    -m, --min-coverage N   ignore nodes with less than N coverage [1]" << endl
          << "    -t, --threads N        number of threads to use [all available]" << endl;
@@ -61,6 +64,8 @@ int main_depth(int argc, char** argv) {
     size_t max_nodes = 1000000;
     int random_seed = time(NULL);
     size_t min_mapq = 0;
+    bool use_gam_index = false;
+    double precision = 0.02;
 
     size_t min_coverage = 1;
 
@@ -78,6 +83,8 @@ int main_depth(int argc, char** argv) {
             {"max-nodes", required_argument, 0, 'n'},
             {"random-seed", required_argument, 0, 's'},
             {"min-mapq", required_argument, 0, 'Q'},
+            {"indexed", no_argument, 0, 'i'},
+            {"precision", required_argument, 0, 'e'},
             {"min-coverage", required_argument, 0, 'm'},
             {"threads", required_argument, 0, 't'},
             {"help", no_argument, 0, 'h'},
@@ -85,7 +92,7 @@ int main_depth(int argc, char** argv) {
         };
 
         int option_index = 0;
-        c = getopt_long (argc, argv, "hk:p:c:b:dg:a:n:s:m:t:",
+        c = getopt_long (argc, argv, "hk:p:c:b:dg:a:n:s:Q:ie:m:t:",
                 long_options, &option_index);
 
         // Detect the end of the options.
@@ -121,6 +128,12 @@ int main_depth(int argc, char** argv) {
         case 'Q':
             min_mapq = parse<size_t>(optarg);
             break;
+        case 'i':
+            use_gam_index = true;
+            break;
+        case 'e':
+            precision = parse<double>(optarg);
+            break;
         case 'm':
             min_coverage = parse<size_t>(optarg);
             break;
@@ -157,6 +170,10 @@ int main_depth(int argc, char** argv) {
         cerr << "error:[vg depth] Exactly one of a pack file (-k), a GAM file (-g), or a GAF file (-a) must be given" << endl;
         exit(1);
     }
+    if (use_gam_index && (gam_filename.empty() || gam_filename == "-")) {
+        cerr << "error:[vg depth] Indexed sampling (-i) requires a sorted GAM file (-g)" << endl;
+        exit(1);
+    }
 
     // Read the graph
     unique_ptr<PathHandleGraph> path_handle_graph;
@@ -217,8 +234,22 @@ int main_depth(int argc, char** argv) {
     if (!gam_filename.empty() || !gaf_filename.empty()) {
         const string& mapping_filename = !gam_filename.empty() ? gam_filename : gaf_filename;
         pair<double, double> mapping_cov;
-        mapping_cov = algorithms::sample_mapping_depth(*graph, mapping_filename, max_nodes, random_seed,
-                                                       min_coverage, min_mapq, !gam_filename.empty() ? "GAM" : "GAF");
+        if (use_gam_index) {
+            GAMIndex gam_index;
+            try {
+                get_input_file(gam_filename + ".gai", [&](istream& index_stream) {
+                        gam_index.load(index_stream);
+                    });
+            } catch (...) {
+                cerr << "error:[vg depth] Unable to load GAM index file: " << gam_filename << ".gai" << endl;
+                exit(1);
+            }
+            mapping_cov = algorithms::sample_mapping_depth(*graph, gam_filename, gam_index, max_nodes, random_seed,
+                                                           min_coverage, min_mapq, precision);
+        } else {
+            mapping_cov = algorithms::sample_mapping_depth(*graph, mapping_filename, max_nodes, random_seed,
+                                                           min_coverage, min_mapq, !gam_filename.empty() ? "GAM" : "GAF");
+        }
         cout << mapping_cov.first << "\t" << sqrt(mapping_cov.second) << endl;
     }
         
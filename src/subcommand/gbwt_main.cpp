@@ -91,6 +91,8 @@ void help_gbwt(char** argv) {
     std::cerr << "        --inputs-as-jobs    create one build job for each input instead of using first-fit heuristic" << std::endl;
     std::cerr << "        --parse-only        store the VCF parses without building GBWTs" << std::endl;
     std::cerr << "                            (use -o for the file name prefix; skips subsequent steps)" << std::endl;
+    std::cerr << "        --stream-parse      build the GBWTs directly from the VCF without storing the parses" << std::endl;
+    std::cerr << "                            (scratch space is bounded by one contig per job)" << std::endl;
     std::cerr << "        --ignore-missing    do not warn when variants are missing from the graph" << std::endl;
     std::cerr << "        --actual-phasing    do not interpret unphased homozygous genotypes as phased" << std::endl;
     std::cerr << "        --force-phasing     replace unphased genotypes with randomly phased ones" << std::endl;
@@ -175,6 +177,7 @@ int main_gbwt(int argc, char** argv)
     constexpr int OPT_EXCLUDE_SAMPLE = 1113;
     constexpr int OPT_PATHS_AS_SAMPLES = 1114;
     constexpr int OPT_GAM_FORMAT = 1115;
+    constexpr int OPT_STREAM_PARSE = 1116;
     constexpr int OPT_CHUNK_SIZE = 1200;
     constexpr int OPT_POS_BUFFER = 1201;
     constexpr int OPT_THREAD_BUFFER = 1202;
@@ -190,7 +193,7 @@ int main_gbwt(int argc, char** argv)
 
     // Input GBWT construction.
     HaplotypeIndexer haplotype_indexer;
-    bool gam_format = false, inputs_as_jobs = false, parse_only = false;
+    bool gam_format = false, inputs_as_jobs = false, parse_only = false, stream_parse = false;
     size_t build_jobs = default_build_jobs();
 
     // Parallel merging.
@@ -235,6 +238,7 @@ int main_gbwt(int argc, char** argv)
                 { "num-jobs", required_argument, 0, OPT_NUM_JOBS },
                 { "inputs-as-jobs", no_argument, 0, OPT_INPUTS_AS_JOBS },
                 { "parse-only", no_argument, 0, OPT_PARSE_ONLY },
+                { "stream-parse", no_argument, 0, OPT_STREAM_PARSE },
                 { "ignore-missing", no_argument, 0, OPT_IGNORE_MISSING },
                 { "actual-phasing", no_argument, 0, OPT_ACTUAL_PHASING },
                 { "force-phasing", no_argument, 0, OPT_FORCE_PHASING },
@@ -347,6 +351,9 @@ int main_gbwt(int argc, char** argv)
         case OPT_PARSE_ONLY:
             parse_only = true;
             break;
+        case OPT_STREAM_PARSE:
+            stream_parse = true;
+            break;
         case OPT_IGNORE_MISSING:
             haplotype_indexer.warn_on_missing_variants = false;
             break;
@@ -561,6 +568,10 @@ int main_gbwt(int argc, char** argv)
                 std::cerr << "error: [vg gbwt]: GBWT construction from VCF files requires input args" << std::endl;
                 std::exit(EXIT_FAILURE);
             }
+            if (parse_only && stream_parse) {
+                std::cerr << "error: [vg gbwt]: --parse-only and --stream-parse are mutually exclusive" << std::endl;
+                std::exit(EXIT_FAILURE);
+            }
             if (parse_only) {
                 haplotype_indexer.batch_file_prefix = gbwt_output;
             }
@@ -666,40 +677,68 @@ int main_gbwt(int argc, char** argv)
             if (jobs.size() > 1 && merge == merge_none) {
                 merge = merge_fast;
             }
-            std::vector<std::vector<std::string>> vcf_parses(jobs.size());
-            if (show_progress) {
-                std::cerr << "Parsing " << jobs.size() << " VCF files using up to " << build_jobs << " parallel jobs" << std::endl;
-            }
-            #pragma omp parallel for schedule(dynamic, 1)
-            for (size_t i = 0; i < jobs.size(); i++) {
-                std::string job_name = "Job " + std::to_string(i);
+            if (stream_parse) {
+                // Parse and build in the same jobs, without intermediate parse files.
+                std::vector<std::string> gbwt_files(jobs.size(), "");
                 if (show_progress) {
-                    #pragma omp critical
-                    {
-                        std::cerr << job_name << ": File " << jobs[i].filename << ", paths {";
-                        for (path_handle_t handle : jobs[i].paths) {
-                            std::cerr << " " << input_graph->get_path_name(handle);
+                    std::cerr << "Building " << jobs.size() << " GBWTs directly from VCF files using up to " << build_jobs << " parallel jobs" << std::endl;
+                }
+                #pragma omp parallel for schedule(dynamic, 1)
+                for (size_t i = 0; i < jobs.size(); i++) {
+                    std::string job_name = "Job " + std::to_string(i);
+                    if (show_progress) {
+                        #pragma omp critical
+                        {
+                            std::cerr << job_name << ": File " << jobs[i].filename << ", paths {";
+                            for (path_handle_t handle : jobs[i].paths) {
+                                std::cerr << " " << input_graph->get_path_name(handle);
+                            }
+                            std::cerr << " }" << std::endl;
                         }
-                        std::cerr << " }" << std::endl;
                     }
+                    std::unique_ptr<gbwt::DynamicGBWT> built = haplotype_indexer.build_gbwt(jobs[i].filename, *input_graph, jobs[i].paths, job_name);
+                    use_or_save(built, gbwts, gbwt_files, i, show_progress);
                 }
-                vcf_parses[i] = haplotype_indexer.parse_vcf(jobs[i].filename, *input_graph, jobs[i].paths, job_name);
-            }
-            // Delete the graph to save memory.
-            clear_graph(input_graph, graph_in_use);
-            if (!parse_only) {
-                std::vector<std::string> gbwt_files(vcf_parses.size(), "");
+                clear_graph(input_graph, graph_in_use);
+                if (jobs.size() > 1) {
+                    input_filenames = gbwt_files; // Use the temporary GBWTs as inputs.
+                }
+            } else {
+                std::vector<std::vector<std::string>> vcf_parses(jobs.size());
                 if (show_progress) {
-                    std::cerr << "Building " << vcf_parses.size() << " GBWTs using up to " << build_jobs << " parallel jobs" << std::endl;
+                    std::cerr << "Parsing " << jobs.size() << " VCF files using up to " << build_jobs << " parallel jobs" << std::endl;
                 }
                 #pragma omp parallel for schedule(dynamic, 1)
-                for (size_t i = 0; i < vcf_parses.size(); i++) {
+                for (size_t i = 0; i < jobs.size(); i++) {
                     std::string job_name = "Job " + std::to_string(i);
-                    std::unique_ptr<gbwt::DynamicGBWT> parsed = haplotype_indexer.build_gbwt(vcf_parses[i], job_name);
-                    use_or_save(parsed, gbwts, gbwt_files, i, show_progress);
+                    if (show_progress) {
+                        #pragma omp critical
+                        {
+                            std::cerr << job_name << ": File " << jobs[i].filename << ", paths {";
+                            for (path_handle_t handle : jobs[i].paths) {
+                                std::cerr << " " << input_graph->get_path_name(handle);
+                            }
+                            std::cerr << " }" << std::endl;
+                        }
+                    }
+                    vcf_parses[i] = haplotype_indexer.parse_vcf(jobs[i].filename, *input_graph, jobs[i].paths, job_name);
                 }
-                if (vcf_parses.size() > 1) {
-                    input_filenames = gbwt_files; // Use the temporary GBWTs as inputs.
+                // Delete the graph to save memory.
+                clear_graph(input_graph, graph_in_use);
+                if (!parse_only) {
+                    std::vector<std::string> gbwt_files(vcf_parses.size(), "");
+                    if (show_progress) {
+                        std::cerr << "Building " << vcf_parses.size() << " GBWTs using up to " << build_jobs << " parallel jobs" << std::endl;
+                    }
+                    #pragma omp parallel for schedule(dynamic, 1)
+                    for (size_t i = 0; i < vcf_parses.size(); i++) {
+                        std::string job_name = "Job " + std::to_string(i);
+                        std::unique_ptr<gbwt::DynamicGBWT> parsed = haplotype_indexer.build_gbwt(vcf_parses[i], job_name);
+                        use_or_save(parsed, gbwts, gbwt_files, i, show_progress);
+                    }
+                    if (vcf_parses.size() > 1) {
+                        input_filenames = gbwt_files; // Use the temporary GBWTs as inputs.
+                    }
                 }
             }
         } else if (build == build_paths) {
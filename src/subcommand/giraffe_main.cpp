@@ -13,6 +13,7 @@
 #include <unordered_set>
 #include <chrono>
 #include <mutex>
+#include <atomic>
 
 #include "subcommand.hpp"
 
@@ -322,9 +323,11 @@ void help_giraffe(char** argv) {
     << "  -s, --cluster-score INT       only extend clusters if they are within INT of the best score [50]" << endl
     << "  -S, --pad-cluster-score INT   also extend clusters within INT of above threshold to get a second-best cluster [0]" << endl
     << "  -u, --cluster-coverage FLOAT  only extend clusters if they are within FLOAT of the best read coverage [0.3]" << endl
+    << "  --adaptive-clusters INT       learn tighter cluster score and coverage thresholds from the first INT single-ended reads [0]" << endl
     << "  -v, --extension-score INT     only align extensions if their score is within INT of the best score [1]" << endl
     << "  -w, --extension-set INT       only align extension sets if their score is within INT of the best score [20]" << endl
     << "  -O, --no-dp                   disable all gapped alignment" << endl
+    << "  --long-reads                  chain seeds colinearly and align between them, for long reads" << endl
     << "  -r, --rescue-attempts         attempt up to INT rescues per read in a pair [15]" << endl
     << "  -A, --rescue-algorithm NAME   use algorithm NAME for rescue (none / dozeu / gssw / haplotypes) [dozeu]" << endl
     << "  -L, --max-fragment-length INT assume that fragment lengths should be smaller than INT when estimating the fragment length distribution" << endl
@@ -332,6 +335,7 @@ void help_giraffe(char** argv) {
     << "  --fragment-stdev FLOAT        force the fragment length distribution to have this standard deviation (requires --fragment-mean)" << endl
     << "  --paired-distance-limit FLOAT cluster pairs of read using a distance limit FLOAT standard deviations greater than the mean [2.0]" << endl
     << "  --rescue-subgraph-size FLOAT  search for rescued alignments FLOAT standard deviations greater than the mean [4.0]" << endl
+    << "  --rescue-cache INT            reuse up to INT rescue subgraphs for mates aligned nearby [0]" << endl
     << "  --track-provenance            track how internal intermediate alignment candidates were arrived at" << endl
     << "  --track-correctness           track if internal intermediate alignment candidates are correct (implies --track-provenance)" << endl
     << "  -t, --threads INT             number of compute threads to use" << endl;
@@ -356,6 +360,9 @@ int main_giraffe(int argc, char** argv) {
     #define OPT_RESCUE_STDEV 1008
     #define OPT_REF_PATHS 1009
     #define OPT_SHOW_WORK 1010
+    #define OPT_ADAPTIVE_CLUSTERS 1011
+    #define OPT_RESCUE_CACHE 1012
+    #define OPT_LONG_READS 1013
     
 
     // initialize parameters with their default options
@@ -394,6 +401,10 @@ int main_giraffe(int argc, char** argv) {
     Range<double> pad_cluster_score = 0;
     //Throw away clusters with coverage this amount below the best 
     Range<double> cluster_coverage = 0.3;
+    //Learn tighter cluster thresholds from this many reads, if nonzero
+    size_t adaptive_clusters = 0;
+    //Chain seeds and align between them instead of clustering them
+    bool long_reads = false;
     //Throw away extension sets with scores that are this amount below the best
     Range<double> extension_set = 20;
     //Throw away extensions with scores that are this amount below the best
@@ -415,6 +426,8 @@ int main_giraffe(int argc, char** argv) {
     double cluster_stdev = 2.0;
     //How many stdevs do we look out when rescuing? 
     double rescue_stdev = 4.0;
+    //How many rescue subgraphs do we keep for reuse?
+    size_t rescue_cache = 0;
     // How many pairs should we be willing to buffer before giving up on fragment length estimation?
     size_t MAX_BUFFERED_PAIRS = 100000;
     // What sample name if any should we apply?
@@ -500,14 +513,17 @@ int main_giraffe(int argc, char** argv) {
             {"cluster-score", required_argument, 0, 's'},
             {"pad-cluster-score", required_argument, 0, 'S'},
             {"cluster-coverage", required_argument, 0, 'u'},
+            {"adaptive-clusters", required_argument, 0, OPT_ADAPTIVE_CLUSTERS},
             {"extension-score", required_argument, 0, 'v'},
             {"extension-set", required_argument, 0, 'w'},
             {"score-fraction", required_argument, 0, 'F'},
             {"no-dp", no_argument, 0, 'O'},
+            {"long-reads", no_argument, 0, OPT_LONG_READS},
             {"rescue-attempts", required_argument, 0, 'r'},
             {"rescue-algorithm", required_argument, 0, 'A'},
             {"paired-distance-limit", required_argument, 0, OPT_CLUSTER_STDEV },
             {"rescue-subgraph-size", required_argument, 0, OPT_RESCUE_STDEV },
+            {"rescue-cache", required_argument, 0, OPT_RESCUE_CACHE },
             {"max-fragment-length", required_argument, 0, 'L' },
             {"fragment-mean", required_argument, 0, OPT_FRAGMENT_MEAN },
             {"fragment-stdev", required_argument, 0, OPT_FRAGMENT_STDEV },
@@ -831,6 +847,10 @@ int main_giraffe(int argc, char** argv) {
                 rescue_stdev = parse<double>(optarg);
                 break;
 
+            case OPT_RESCUE_CACHE:
+                rescue_cache = parse<size_t>(optarg);
+                break;
+
             case OPT_TRACK_PROVENANCE:
                 track_provenance = true;
                 break;
@@ -843,6 +863,14 @@ int main_giraffe(int argc, char** argv) {
             case OPT_SHOW_WORK:
                 show_work = true;
                 break;
+
+            case OPT_ADAPTIVE_CLUSTERS:
+                adaptive_clusters = parse<size_t>(optarg);
+                break;
+
+            case OPT_LONG_READS:
+                long_reads = true;
+                break;
                 
             case 't':
             {
@@ -966,6 +994,13 @@ int main_giraffe(int argc, char** argv) {
         exit(1);
     }
     
+    if (paired && adaptive_clusters != 0) {
+        // Paired mapping maps the ends with map() before it knows the
+        // fragment length distribution, so it would train and prune too.
+        cerr << "error:[vg giraffe] Adaptive cluster thresholds (--adaptive-clusters) can only be used with single-ended reads." << endl;
+        exit(1);
+    }
+    
     if (have_input_file(optind, argc, argv)) {
         // TODO: work out how to interpret additional files as reads.
         cerr << "error:[vg giraffe] Extraneous input file: " << get_input_file_name(optind, argc, argv) << endl;
@@ -1122,6 +1157,11 @@ int main_giraffe(int argc, char** argv) {
         }
         minimizer_mapper.cluster_coverage_threshold = cluster_coverage;
 
+        if (show_progress && adaptive_clusters != 0) {
+            cerr << "--adaptive-clusters " << adaptive_clusters << endl;
+        }
+        minimizer_mapper.adaptive_cluster_training_reads = adaptive_clusters;
+
         if (show_progress) {
             cerr << "--extension-score " << extension_score << endl;
         }
@@ -1137,6 +1177,11 @@ int main_giraffe(int argc, char** argv) {
         }
         minimizer_mapper.do_dp = do_dp;
 
+        if (show_progress && long_reads) {
+            cerr << "--long-reads " << endl;
+        }
+        minimizer_mapper.long_read_chaining = long_reads;
+
         if (show_progress) {
             cerr << "--max-multimaps " << max_multimaps << endl;
         }
@@ -1162,6 +1207,9 @@ int main_giraffe(int argc, char** argv) {
         }
         minimizer_mapper.show_work = show_work;
 
+        // GAF output drops the annotations, so don't spend time making them.
+        minimizer_mapper.annotate_mappings = (output_format != "GAF");
+
         if (show_progress && paired) {
             if (forced_mean && forced_stdev) {
                 cerr << "--fragment-mean " << fragment_mean << endl; 
@@ -1169,12 +1217,14 @@ int main_giraffe(int argc, char** argv) {
             }
             cerr << "--paired-distance-limit " << cluster_stdev << endl;
             cerr << "--rescue-subgraph-size " << rescue_stdev << endl;
+            cerr << "--rescue-cache " << rescue_cache << endl;
             cerr << "--rescue-attempts " << rescue_attempts << endl;
             cerr << "--rescue-algorithm " << algorithm_names[rescue_algorithm] << endl;
         }
         minimizer_mapper.max_fragment_length = fragment_length;
         minimizer_mapper.paired_distance_stdevs = cluster_stdev;
         minimizer_mapper.rescue_subgraph_stdevs = rescue_stdev;
+        minimizer_mapper.rescue_subgraph_cache_size = rescue_cache;
         minimizer_mapper.max_rescue_attempts = rescue_attempts;
         minimizer_mapper.rescue_algorithm = rescue_algorithm;
 
@@ -1219,35 +1269,28 @@ int main_giraffe(int argc, char** argv) {
             if (interleaved || !fastq_filename_2.empty()) {
                 //Map paired end from either one gam or fastq file or two fastq files
 
-                // a buffer to hold read pairs that can't be unambiguously mapped before the fragment length distribution
-                // is estimated
-                // note: sufficient to have only one buffer because multithreading code enforces single threaded mode
-                // during distribution estimation
-                vector<pair<Alignment, Alignment>> ambiguous_pair_buffer;
-                
-                // Track whether the distribution was ready, so we can detect when it becomes ready and capture the all-threads start time.
-                bool distribution_was_ready = false;
-
-                // Define how to know if the paired end distribution is ready
-                auto distribution_is_ready = [&]() {
-                    bool is_ready = minimizer_mapper.fragment_distr_is_finalized();
-                    if (is_ready && !distribution_was_ready) {
-                        // It has become ready now.
-                        distribution_was_ready = true;
-                        // Remember when now is.
-                        all_threads_start = std::chrono::system_clock::now();
-                    }
-                    return is_ready;
-                };
+                // All the threads start at once, and learn the fragment length distribution together.
+                all_threads_start = first_thread_start;
+
+                // buffers to hold read pairs that can't be unambiguously mapped before the fragment length distribution
+                // is estimated, one per thread
+                vector<vector<pair<Alignment, Alignment>>> ambiguous_pair_buffers(thread_count);
+                // and how many pairs they hold in total
+                atomic<size_t> ambiguous_pair_count(0);
+                // only one thread needs to force the distribution finalized
+                atomic_flag distribution_forced = ATOMIC_FLAG_INIT;
                 
                 // Define a way to force the distribution ready
                 auto require_distribution_finalized = [&]() {
                     if (!minimizer_mapper.fragment_distr_is_finalized()){
-                        cerr << "warning[vg::giraffe]: Finalizing fragment length distribution before reaching maximum sample size" << endl;
-                        cerr << "                      mapped " << minimizer_mapper.get_fragment_length_sample_size() 
-                             << " reads single ended with " << ambiguous_pair_buffer.size() << " pairs of reads left unmapped" << endl;
-                        cerr << "                      mean: " << minimizer_mapper.get_fragment_length_mean() << ", stdev: " 
-                             << minimizer_mapper.get_fragment_length_stdev() << endl;
+                        #pragma omp critical (cerr)
+                        {
+                            cerr << "warning[vg::giraffe]: Finalizing fragment length distribution before reaching maximum sample size" << endl;
+                            cerr << "                      mapped " << minimizer_mapper.get_fragment_length_sample_size() 
+                                 << " reads single ended with " << ambiguous_pair_count.load() << " pairs of reads left unmapped" << endl;
+                            cerr << "                      mean: " << minimizer_mapper.get_fragment_length_mean() << ", stdev: " 
+                                 << minimizer_mapper.get_fragment_length_stdev() << endl;
+                        }
                         minimizer_mapper.finalize_fragment_length_distr();
                     }
                 };
@@ -1255,6 +1298,8 @@ int main_giraffe(int argc, char** argv) {
                 // Define how to align and output a read pair, in a thread.
                 auto map_read_pair = [&](Alignment& aln1, Alignment& aln2) {
                     
+                    vector<pair<Alignment, Alignment>>& ambiguous_pair_buffer = ambiguous_pair_buffers.at(omp_get_thread_num());
+                    size_t buffered_before = ambiguous_pair_buffer.size();
                     pair<vector<Alignment>, vector<Alignment>> mapped_pairs = minimizer_mapper.map_paired(aln1, aln2, ambiguous_pair_buffer);
                     if (!mapped_pairs.first.empty() && !mapped_pairs.second.empty()) {
                         //If we actually tried to map this paired end
@@ -1277,11 +1322,17 @@ int main_giraffe(int argc, char** argv) {
                         reads_mapped_by_thread.at(omp_get_thread_num()) += 2;
                     }
                     
-                    if (!minimizer_mapper.fragment_distr_is_finalized() && ambiguous_pair_buffer.size() >= MAX_BUFFERED_PAIRS) {
+                    if (ambiguous_pair_buffer.size() > buffered_before &&
+                        ++ambiguous_pair_count >= MAX_BUFFERED_PAIRS &&
+                        !minimizer_mapper.fragment_distr_is_finalized() &&
+                        !distribution_forced.test_and_set()) {
                         // We risk running out of memory if we keep this up.
-                        cerr << "warning[vg::giraffe]: Encountered " << ambiguous_pair_buffer.size() << " ambiguously-paired reads before finding enough" << endl
-                             << "                      unambiguously-paired reads to learn fragment length distribution. Are you sure" << endl
-                             << "                      your reads are paired and your graph is not a hairball?" << endl;
+                        #pragma omp critical (cerr)
+                        {
+                            cerr << "warning[vg::giraffe]: Encountered " << ambiguous_pair_count.load() << " ambiguously-paired reads before finding enough" << endl
+                                 << "                      unambiguously-paired reads to learn fragment length distribution. Are you sure" << endl
+                                 << "                      your reads are paired and your graph is not a hairball?" << endl;
+                        }
                         require_distribution_finalized();
                     }
                 };
@@ -1290,33 +1341,39 @@ int main_giraffe(int argc, char** argv) {
                     // GAM file to remap
                     get_input_file(gam_filename, [&](istream& in) {
                         // Map pairs of reads to the emitter
-                        vg::io::for_each_interleaved_pair_parallel_after_wait<Alignment>(in, map_read_pair, distribution_is_ready);
+                        vg::io::for_each_interleaved_pair_parallel<Alignment>(in, map_read_pair);
                     });
                 } else if (!fastq_filename_2.empty()) {
                     //A pair of FASTQ files to map
-                    fastq_paired_two_files_for_each_parallel_after_wait(fastq_filename_1, fastq_filename_2, map_read_pair, distribution_is_ready);
+                    fastq_paired_two_files_for_each_parallel(fastq_filename_1, fastq_filename_2, map_read_pair);
 
 
                 } else if ( !fastq_filename_1.empty()) {
                     // An interleaved FASTQ file to map, map all its pairs in parallel.
-                    fastq_paired_interleaved_for_each_parallel_after_wait(fastq_filename_1, map_read_pair, distribution_is_ready);
+                    fastq_paired_interleaved_for_each_parallel(fastq_filename_1, map_read_pair);
                 }
 
                 // Now map all the ambiguous pairs
                 // Make sure fragment length distribution is finalized first.
                 require_distribution_finalized();
-                for (pair<Alignment, Alignment>& alignment_pair : ambiguous_pair_buffer) {
+                for (vector<pair<Alignment, Alignment>>& ambiguous_pair_buffer : ambiguous_pair_buffers) {
+                    #pragma omp parallel for schedule(dynamic, 1)
+                    for (size_t i = 0; i < ambiguous_pair_buffer.size(); ++i) {
+                        pair<Alignment, Alignment>& alignment_pair = ambiguous_pair_buffer[i];
 
-                    auto mapped_pairs = minimizer_mapper.map_paired(alignment_pair.first, alignment_pair.second);
-                    // Work out whether it could be properly paired or not, if that is relevant.
-                    int64_t tlen_limit = 0;
-                    if (hts_output && minimizer_mapper.fragment_distr_is_finalized()) {
-                         tlen_limit = minimizer_mapper.get_fragment_length_mean() + 6 * minimizer_mapper.get_fragment_length_stdev();
+                        auto mapped_pairs = minimizer_mapper.map_paired(alignment_pair.first, alignment_pair.second);
+                        // Work out whether it could be properly paired or not, if that is relevant.
+                        int64_t tlen_limit = 0;
+                        if (hts_output && minimizer_mapper.fragment_distr_is_finalized()) {
+                             tlen_limit = minimizer_mapper.get_fragment_length_mean() + 6 * minimizer_mapper.get_fragment_length_stdev();
+                        }
+                        // Emit the read
+                        alignment_emitter->emit_mapped_pair(std::move(mapped_pairs.first), std::move(mapped_pairs.second), tlen_limit);
+                        // Record that we mapped a read.
+                        reads_mapped_by_thread.at(omp_get_thread_num()) += 2;
                     }
-                    // Emit the read
-                    alignment_emitter->emit_mapped_pair(std::move(mapped_pairs.first), std::move(mapped_pairs.second), tlen_limit);
-                    // Record that we mapped a read.
-                    reads_mapped_by_thread.at(omp_get_thread_num()) += 2;
+                    // Free the pairs as we go
+                    vector<pair<Alignment, Alignment>>().swap(ambiguous_pair_buffer);
                 }
             } else {
                 // Map single-ended
@@ -1375,6 +1432,10 @@ int main_giraffe(int argc, char** argv) {
             cerr << "Memory footprint: " << gbwt::inGigabytes(gbwt::memoryUsage()) << " GB" << endl;
         }
         
+        if (adaptive_clusters != 0) {
+            minimizer_mapper.report_adaptive_clusters(cerr);
+        }
+        
         
         if (report) {
             // Log output filename and mapping speed in reads/second/thread to report TSV
@@ -23,7 +23,11 @@
 #include <vg/io/vpkg.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <tuple>
 #include <vector>
 
 #include <getopt.h>
@@ -42,6 +46,9 @@ using namespace vg;
 // Using too many threads just wastes CPU time without speeding up the construction.
 constexpr int DEFAULT_MAX_THREADS = 16;
 
+// With partitioned construction, insert buffered hits into the index once there are this many.
+constexpr size_t DEFAULT_MAX_BUFFERED = 32 * 1024 * 1024;
+
 int get_default_threads() {
     return std::min(omp_get_max_threads(), DEFAULT_MAX_THREADS);
 }
@@ -58,6 +65,183 @@ size_t get_default_s() {
     return IndexManager::minimizer_s;
 }
 
+//------------------------------------------------------------------------------
+
+/// A minimizer hit with its payload, waiting to be inserted into the index.
+typedef std::tuple<gbwtgraph::DefaultMinimizerIndex::minimizer_type, pos_t, gbwtgraph::payload_type> buffered_hit_type;
+
+/// Sort the hits by key and position and remove the duplicates.
+void sort_and_deduplicate(std::vector<buffered_hit_type>& hits) {
+    auto less = [](const buffered_hit_type& a, const buffered_hit_type& b) -> bool {
+        if (std::get<0>(a).key == std::get<0>(b).key) {
+            return std::get<1>(a) < std::get<1>(b);
+        }
+        return std::get<0>(a).key < std::get<0>(b).key;
+    };
+    auto equal = [](const buffered_hit_type& a, const buffered_hit_type& b) -> bool {
+        return std::get<0>(a).key == std::get<0>(b).key && std::get<1>(a) == std::get<1>(b);
+    };
+    std::sort(hits.begin(), hits.end(), less);
+    hits.erase(std::unique(hits.begin(), hits.end(), equal), hits.end());
+}
+
+/**
+ * Index the haplotypes in the graph like gbwtgraph::index_haplotypes(), but
+ * without a shared critical section on the index in the inner loop.
+ *
+ * Each thread buffers the hits it finds in partial tables, one per range of
+ * node IDs, and computes the payloads itself. Full thread buffers are
+ * deduplicated and handed to a shared per-range table under a per-range lock.
+ * At the end, the per-range tables are deduplicated in parallel and inserted
+ * into the index range by range. If more than max_buffered hits are waiting,
+ * the waiting hits are inserted right away to bound memory usage.
+ *
+ * Returns the number of hits found before deduplication.
+ */
+size_t index_haplotypes_partitioned(const gbwtgraph::GBWTGraph& graph, gbwtgraph::DefaultMinimizerIndex& index,
+                                    const std::function<gbwtgraph::payload_type(const pos_t&)>& get_payload,
+                                    size_t max_buffered, bool progress) {
+
+    typedef gbwtgraph::DefaultMinimizerIndex::minimizer_type minimizer_type;
+
+    int threads = omp_get_max_threads();
+    size_t num_ranges = threads * 4;
+    nid_t min_id = graph.min_node_id();
+    nid_t id_span = std::max<nid_t>(graph.max_node_id() - min_id + 1, 1);
+    auto range_of = [&](nid_t node_id) -> size_t {
+        return ((size_t) (node_id - min_id) * num_ranges) / id_span;
+    };
+
+    // Per-thread partial tables, by range.
+    constexpr size_t THREAD_BUFFER_SIZE = 64 * 1024;
+    std::vector<std::vector<std::vector<std::pair<minimizer_type, pos_t>>>> thread_hits(threads);
+    std::vector<size_t> thread_hit_counts(threads, 0);
+    for (auto& ranges : thread_hits) {
+        ranges.resize(num_ranges);
+    }
+
+    // Shared tables, by range.
+    std::vector<std::vector<buffered_hit_type>> range_hits(num_ranges);
+    std::vector<std::mutex> range_locks(num_ranges);
+    std::atomic<size_t> total_buffered(0);
+    std::atomic<size_t> total_found(0);
+
+    // Insert everything waiting in the shared tables into the index.
+    // Must be called with no other thread touching the shared tables.
+    auto drain_ranges = [&]() {
+        for (auto& hits : range_hits) {
+            sort_and_deduplicate(hits);
+            for (auto& hit : hits) {
+                index.insert(std::get<0>(hit), std::get<1>(hit), std::get<2>(hit));
+            }
+            std::vector<buffered_hit_type>().swap(hits);
+        }
+        total_buffered = 0;
+    };
+
+    auto flush_thread = [&](int thread_id) {
+        for (size_t range = 0; range < num_ranges; range++) {
+            auto& hits = thread_hits[thread_id][range];
+            if (hits.empty()) {
+                continue;
+            }
+            std::vector<buffered_hit_type> with_payloads;
+            with_payloads.reserve(hits.size());
+            for (auto& hit : hits) {
+                with_payloads.emplace_back(hit.first, hit.second, gbwtgraph::payload_type());
+            }
+            sort_and_deduplicate(with_payloads);
+            for (auto& hit : with_payloads) {
+                std::get<2>(hit) = get_payload(std::get<1>(hit));
+            }
+            {
+                std::lock_guard<std::mutex> lock(range_locks[range]);
+                range_hits[range].insert(range_hits[range].end(), with_payloads.begin(), with_payloads.end());
+            }
+            total_buffered += with_payloads.size();
+            hits.clear();
+        }
+        thread_hit_counts[thread_id] = 0;
+
+        if (total_buffered > max_buffered) {
+            #pragma omp critical (minimizer_index)
+            {
+                if (total_buffered > max_buffered) {
+                    // Take every range lock so nobody else adds hits while we drain.
+                    for (auto& lock : range_locks) {
+                        lock.lock();
+                    }
+                    drain_ranges();
+                    for (auto& lock : range_locks) {
+                        lock.unlock();
+                    }
+                }
+            }
+        }
+    };
+
+    auto find_minimizers = [&](const std::vector<handle_t>& traversal, const std::string& seq) {
+        std::vector<minimizer_type> minimizers = index.minimizers(seq); // Calls syncmers() when appropriate.
+        auto iter = traversal.begin();
+        size_t node_start = 0;
+        int thread_id = omp_get_thread_num();
+        size_t found = 0;
+        for (minimizer_type& minimizer : minimizers) {
+            if (minimizer.empty()) {
+                continue;
+            }
+
+            // Find the node covering minimizer starting position.
+            size_t node_length = graph.get_length(*iter);
+            while (node_start + node_length <= minimizer.offset) {
+                node_start += node_length;
+                ++iter;
+                node_length = graph.get_length(*iter);
+            }
+            pos_t pos = make_pos_t(graph.get_id(*iter), graph.get_is_reverse(*iter), minimizer.offset - node_start);
+            if (minimizer.is_reverse) {
+                pos = reverse_base_pos(pos, node_length);
+            }
+            thread_hits[thread_id][range_of(id(pos))].emplace_back(minimizer, pos);
+            found++;
+        }
+        thread_hit_counts[thread_id] += found;
+        total_found += found;
+        if (thread_hit_counts[thread_id] >= THREAD_BUFFER_SIZE) {
+            flush_thread(thread_id);
+        }
+    };
+
+    double start = gbwt::readTimer();
+    gbwtgraph::for_each_haplotype_window(graph, index.window_bp(), find_minimizers, (threads > 1));
+    if (progress) {
+        double seconds = gbwt::readTimer() - start;
+        std::cerr << "Found " << total_found << " minimizer hits in " << seconds << " seconds ("
+                  << (total_found / std::max(seconds, 1e-9)) << " hits/second)" << std::endl;
+    }
+
+    // Merge the partial tables: finish the thread buffers in parallel, then
+    // deduplicate each range in parallel.
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int thread_id = 0; thread_id < threads; thread_id++) {
+        flush_thread(thread_id);
+    }
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (size_t range = 0; range < num_ranges; range++) {
+        sort_and_deduplicate(range_hits[range]);
+    }
+    drain_ranges();
+    if (progress) {
+        double seconds = gbwt::readTimer() - start;
+        std::cerr << "Merged " << num_ranges << " node ranges from " << threads << " threads in " << seconds
+                  << " seconds total" << std::endl;
+    }
+
+    return total_found;
+}
+
+//------------------------------------------------------------------------------
+
 void help_minimizer(char** argv) {
     std::cerr << "usage: " << argv[0] << " minimizer -g gbwt_name -i index_name [options] graph" << std::endl;
     std::cerr << std::endl;
@@ -82,7 +266,10 @@ void help_minimizer(char** argv) {
     std::cerr << "    -G, --gbwt-graph        the input graph is a GBWTGraph" << std::endl;
     std::cerr << "    -p, --progress          show progress information" << std::endl;
     std::cerr << "    -t, --threads N         use N threads for index construction (default " << get_default_threads() << ")" << std::endl;
-    std::cerr << "                            (using more than " << DEFAULT_MAX_THREADS << " threads rarely helps)" << std::endl;
+    std::cerr << "                            (using more than " << DEFAULT_MAX_THREADS << " threads rarely helps without -P)" << std::endl;
+    std::cerr << "    -P, --partitioned       build per-thread tables by node range and merge them; scales to more" << std::endl;
+    std::cerr << "                            threads (default threads " << omp_get_max_threads() << ")" << std::endl;
+    std::cerr << "    -B, --max-buffered N    with -P, insert buffered hits once there are more than N (default " << DEFAULT_MAX_BUFFERED << ")" << std::endl;
     std::cerr << std::endl;
 }
 
@@ -101,7 +288,9 @@ int main_minimizer(int argc, char** argv) {
     bool use_syncmers = false;
     bool is_gbwt_graph = false;
     bool progress = false;
-    int threads = get_default_threads();
+    bool partitioned = false;
+    size_t max_buffered = DEFAULT_MAX_BUFFERED;
+    int threads = 0;
 
     int c;
     optind = 2; // force optind past command positional argument
@@ -119,11 +308,13 @@ int main_minimizer(int argc, char** argv) {
             { "gbwt-graph", no_argument, 0, 'G' },
             { "progress", no_argument, 0, 'p' },
             { "threads", required_argument, 0, 't' },
+            { "partitioned", no_argument, 0, 'P' },
+            { "max-buffered", required_argument, 0, 'B' },
             { 0, 0, 0, 0 }
         };
 
         int option_index = 0;
-        c = getopt_long(argc, argv, "g:i:k:w:bs:d:l:Gpt:h", long_options, &option_index);
+        c = getopt_long(argc, argv, "g:i:k:w:bs:d:l:Gpt:PB:h", long_options, &option_index);
         if (c == -1) { break; } // End of options.
 
         switch (c)
@@ -163,6 +354,12 @@ int main_minimizer(int argc, char** argv) {
             threads = std::min(threads, omp_get_max_threads());
             threads = std::max(threads, 1);
             break;
+        case 'P':
+            partitioned = true;
+            break;
+        case 'B':
+            max_buffered = parse<size_t>(optarg);
+            break;
 
         case 'h':
         case '?':
@@ -181,6 +378,10 @@ int main_minimizer(int argc, char** argv) {
         return 1;
     }
     graph_name = argv[optind];
+    if (threads == 0) {
+        // Partitioned construction is not limited by contention on the index.
+        threads = (partitioned ? omp_get_max_threads() : get_default_threads());
+    }
     omp_set_num_threads(threads);
 
     double start = gbwt::readTimer();
@@ -238,14 +439,23 @@ int main_minimizer(int argc, char** argv) {
         }
         std::cerr << std::endl;
     }
+    std::function<gbwtgraph::payload_type(const pos_t&)> get_payload;
     if (distance_name.empty()) {
-        gbwtgraph::index_haplotypes(*gbwt_graph, *index, [](const pos_t&) -> gbwtgraph::payload_type {
+        get_payload = [](const pos_t&) -> gbwtgraph::payload_type {
             return MIPayload::NO_CODE;
-        });
+        };
     } else {
-        gbwtgraph::index_haplotypes(*gbwt_graph, *index, [&](const pos_t& pos) -> gbwtgraph::payload_type {
+        get_payload = [&](const pos_t& pos) -> gbwtgraph::payload_type {
             return MIPayload::encode(distance_index->get_minimizer_distances(pos));
-        });
+        };
+    }
+    if (partitioned) {
+        if (progress) {
+            std::cerr << "Using partitioned construction with " << threads << " threads" << std::endl;
+        }
+        index_haplotypes_partitioned(*gbwt_graph, *index, get_payload, max_buffered, progress);
+    } else {
+        gbwtgraph::index_haplotypes(*gbwt_graph, *index, get_payload);
     }
     gbwt_graph.reset(nullptr);
     gbwt_index.reset(nullptr);
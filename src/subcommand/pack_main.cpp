@@ -3,6 +3,8 @@
 #include "../xg.hpp"
 #include "../utility.hpp"
 #include "../packer.hpp"
+#include "../path.hpp"
+#include "../algorithms/coverage_depth.hpp"
 #include <vg/io/stream.hpp>
 #include <vg/io/vpkg.hpp>
 #include <handlegraph/handle_graph.hpp>
@@ -19,7 +21,10 @@ void help_pack(char** argv) {
          << "options:" << endl
          << "    -x, --xg FILE          use this basis graph (any format accepted, does not have to be xg)" << endl
          << "    -o, --packs-out FILE   write compressed coverage packs to this output file" << endl
+         << "    -C, --chunked N        write the packs in chunks of N nodes, which can be loaded by node range [default: off]" << endl
          << "    -i, --packs-in FILE    begin by summing coverage packs from each provided FILE" << endl
+         << "    -M, --matrix-out FILE  write a multi-sample coverage matrix with one sample per -i pack, rather than summing them" << endl
+         << "                           (with -d, write it as a table with one coverage column per sample)" << endl
          << "    -g, --gam FILE         read alignments from this GAM file (could be '-' for stdin)" << endl
          << "    -a, --gaf FILE         read alignments from this GAF file (could be '-' for stdin)" << endl
          << "    -d, --as-table         write table on stdout representing packs" << endl
@@ -31,6 +36,8 @@ void help_pack(char** argv) {
          << "    -N, --node-list FILE   a white space or line delimited list of nodes to collect" << endl
          << "    -Q, --min-mapq N       ignore reads with MAPQ < N and positions with base quality < N [default: 0]" << endl
          << "    -c, --expected-cov N   expected coverage.  used only for memory tuning [default : 128]" << endl
+         << "    -P, --depth-index FILE also write a binned depth index of the reference paths for vg call -D" << endl
+         << "    -p, --ref-path NAME    reference path for the depth index (may repeat) [default: all non-alt paths]" << endl
          << "    -t, --threads N        use N threads (defaults to numCPUs)" << endl;
 }
 
@@ -40,6 +47,8 @@ int main_pack(int argc, char** argv) {
     string xg_name;
     vector<string> packs_in;
     string packs_out;
+    size_t nodes_per_chunk = 0;
+    string matrix_out;
     string gam_in;
     string gaf_in;
     bool write_table = false;
@@ -52,6 +61,8 @@ int main_pack(int argc, char** argv) {
     int min_mapq = 0;
     int min_baseq = 0;
     size_t expected_coverage = 128;
+    string depth_index_out;
+    vector<string> ref_paths;
 
     if (argc == 2) {
         help_pack(argv);
@@ -66,7 +77,9 @@ int main_pack(int argc, char** argv) {
             {"help", no_argument, 0, 'h'},
             {"xg", required_argument,0, 'x'},
             {"packs-out", required_argument,0, 'o'},
+            {"chunked", required_argument, 0, 'C'},
             {"count-in", required_argument, 0, 'i'},
+            {"matrix-out", required_argument, 0, 'M'},
             {"gam", required_argument, 0, 'g'},
             {"gaf", required_argument, 0, 'a'},
             {"as-table", no_argument, 0, 'd'},
@@ -79,11 +92,13 @@ int main_pack(int argc, char** argv) {
             {"bin-size", required_argument, 0, 'b'},
             {"min-mapq", required_argument, 0, 'Q'},
             {"expected-cov", required_argument, 0, 'c'},
+            {"depth-index", required_argument, 0, 'P'},
+            {"ref-path", required_argument, 0, 'p'},
             {0, 0, 0, 0}
 
         };
         int option_index = 0;
-        c = getopt_long (argc, argv, "hx:o:i:g:a:dDut:eb:n:N:Q:c:",
+        c = getopt_long (argc, argv, "hx:o:C:i:M:g:a:dDut:eb:n:N:Q:c:P:p:",
                 long_options, &option_index);
 
         // Detect the end of the options.
@@ -103,9 +118,19 @@ int main_pack(int argc, char** argv) {
         case 'o':
             packs_out = optarg;
             break;
+        case 'C':
+            nodes_per_chunk = parse<size_t>(optarg);
+            if (nodes_per_chunk == 0) {
+                cerr << "error [vg pack]: Chunk size (-C) must be positive" << endl;
+                exit(1);
+            }
+            break;
         case 'i':
             packs_in.push_back(optarg);
             break;
+        case 'M':
+            matrix_out = optarg;
+            break;
         case 'g':
             gam_in = optarg;
             break;
@@ -150,6 +175,12 @@ int main_pack(int argc, char** argv) {
         case 'c':
             expected_coverage = parse<size_t>(optarg);
             break;
+        case 'P':
+            depth_index_out = optarg;
+            break;
+        case 'p':
+            ref_paths.push_back(optarg);
+            break;
         default:
             abort();
         }
@@ -164,7 +195,18 @@ int main_pack(int argc, char** argv) {
         handle_graph = vg::io::VPKG::load_one<HandleGraph>(xg_name);
     }
     bdsg::VectorizableOverlayHelper overlay_helper;
-    graph = dynamic_cast<HandleGraph*>(overlay_helper.apply(handle_graph.get()));
+    bdsg::PathVectorizableOverlayHelper path_overlay_helper;
+    if (!depth_index_out.empty()) {
+        // The depth index is computed along paths
+        PathHandleGraph* path_graph = dynamic_cast<PathHandleGraph*>(handle_graph.get());
+        if (path_graph == nullptr) {
+            cerr << "error [vg pack]: The depth index (-P) requires a graph with paths" << endl;
+            exit(1);
+        }
+        graph = dynamic_cast<HandleGraph*>(path_overlay_helper.apply(path_graph));
+    } else {
+        graph = dynamic_cast<HandleGraph*>(overlay_helper.apply(handle_graph.get()));
+    }
 
     if (gam_in.empty() && packs_in.empty() && gaf_in.empty()) {
         cerr << "error [vg pack]: Input must be provided with -g, -a or -i" << endl;
@@ -176,8 +218,15 @@ int main_pack(int argc, char** argv) {
         exit(1);
     }
 
-    if (packs_out.empty() && write_table == false && write_edge_table == false && write_qual_table == false) {
-        cerr << "error [vg pack]: Output must be selected with -o, -d or -D" << endl;
+    if (packs_out.empty() && depth_index_out.empty() && matrix_out.empty() &&
+        write_table == false && write_edge_table == false && write_qual_table == false) {
+        cerr << "error [vg pack]: Output must be selected with -o, -P, -M, -d or -D" << endl;
+        exit(1);
+    }
+
+    if (!matrix_out.empty() && (packs_in.empty() || !gam_in.empty() || !gaf_in.empty() || !packs_out.empty() ||
+                                !depth_index_out.empty() || write_edge_table || write_qual_table)) {
+        cerr << "error [vg pack]: -M takes one sample per -i pack, and can only be combined with -d" << endl;
         exit(1);
     }
 
@@ -198,6 +247,19 @@ int main_pack(int argc, char** argv) {
         nli.close();
     }
 
+    if (!matrix_out.empty()) {
+        // transpose the packs into one matrix, rather than summing them
+        Packers packers(graph);
+        packers.load(packs_in);
+        CoverageMatrix matrix(graph);
+        matrix.build(packers);
+        matrix.save_to_file(matrix_out);
+        if (write_table) {
+            matrix.as_table(cout, node_ids);
+        }
+        return 0;
+    }
+
     // get a data width from our expected coverage, using simple heuristic of counting
     // bits needed to store double the coverage
     size_t data_width = Packer::estimate_data_width(expected_coverage);
@@ -244,7 +306,34 @@ int main_pack(int argc, char** argv) {
     }
 
     if (!packs_out.empty()) {
-        packer.save_to_file(packs_out);
+        if (nodes_per_chunk > 0) {
+            packer.save_chunked_to_file(packs_out, nodes_per_chunk);
+        } else {
+            packer.save_to_file(packs_out);
+        }
+    }
+    if (!depth_index_out.empty()) {
+        // Compute the depth index now, while we have the coverage, so vg call doesn't have to
+        packer.make_compact();
+        const PathHandleGraph* path_graph = dynamic_cast<const PathHandleGraph*>(graph);
+        if (ref_paths.empty()) {
+            path_graph->for_each_path_handle([&](path_handle_t path_handle) {
+                    string name = path_graph->get_path_name(path_handle);
+                    if (!Paths::is_alt(name)) {
+                        ref_paths.push_back(name);
+                    }
+                });
+        }
+        for (const string& ref_path : ref_paths) {
+            if (!path_graph->has_path(ref_path)) {
+                cerr << "error [vg pack]: Reference path \"" << ref_path << "\" not found in graph" << endl;
+                exit(1);
+            }
+        }
+        algorithms::BinnedDepthIndexParams depth_params;
+        algorithms::save_binned_depth_index(algorithms::binned_packed_depth_index(packer, ref_paths, depth_params),
+                                            depth_params, algorithms::packed_coverage_fingerprint(packer),
+                                            depth_index_out);
     }
     if (write_table || write_edge_table || write_qual_table) {
         packer.make_compact();
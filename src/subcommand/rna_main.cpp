@@ -290,9 +290,9 @@ int32_t main_rna(int32_t argc, char** argv) {
         double time_sort_start = gcsa::readTimer();
         if (show_progress) { cerr << "[vg rna] Topological sorting and compacting splice graph ..." << endl; }
         
-        transcriptome.compact_ordered();
+        bool is_local = transcriptome.compact_ordered();
         
-        if (show_progress) { cerr << "[vg rna] Splice graph sorted and compacted in " << gcsa::readTimer() - time_sort_start << " seconds, " << gcsa::inGigabytes(gcsa::memoryUsage()) << " GB" << endl; };
+        if (show_progress) { cerr << "[vg rna] Splice graph sorted " << (is_local ? "(local order) " : "") << "and compacted in " << gcsa::readTimer() - time_sort_start << " seconds, " << gcsa::inGigabytes(gcsa::memoryUsage()) << " GB" << endl; };
     }
 
 
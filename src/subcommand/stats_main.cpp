@@ -8,11 +8,14 @@
 #include <unistd.h>
 #include <getopt.h>
 
+#include <atomic>
 #include <list>
 #include <fstream>
+#include <unordered_map>
 
 #include <vg/io/vpkg.hpp>
 #include <vg/io/stream.hpp>
+#include <vg/io/alignment_io.hpp>
 
 #include "subcommand.hpp"
 #include "../algorithms/distance_to_head.hpp"
@@ -51,6 +54,7 @@ void help_stats(char** argv) {
          << "    -d, --to-head         show distance to head for each provided node" << endl
          << "    -t, --to-tail         show distance to head for each provided node" << endl
          << "    -a, --alignments FILE compute stats for reads aligned to the graph" << endl
+         << "    -g, --gaf FILE        compute stats for reads aligned to the graph in GAF format (requires graph)" << endl
          << "    -r, --node-id-range   X:Y where X and Y are the smallest and largest "
         "node id in the graph, respectively" << endl
          << "    -o, --overlap PATH    for each overlapping path mapping in the graph write a table:" << endl
@@ -89,6 +93,8 @@ int main_stats(int argc, char** argv) {
     // What alignments GAM file should we read and compute stats on with the
     // graph?
     string alignments_filename;
+    // Is it GAF instead of GAM?
+    bool alignments_are_gaf = false;
     vector<string> paths_to_overlap;
     bool overlap_all_paths = false;
     bool snarl_stats = false;
@@ -113,6 +119,7 @@ int main_stats(int argc, char** argv) {
             {"to-tail", no_argument, 0, 't'},
             {"node", required_argument, 0, 'n'},
             {"alignments", required_argument, 0, 'a'},
+            {"gaf", required_argument, 0, 'g'},
             {"is-acyclic", no_argument, 0, 'A'},
             {"node-id-range", no_argument, 0, 'r'},
             {"verbose", no_argument, 0, 'v'},
@@ -125,7 +132,7 @@ int main_stats(int argc, char** argv) {
         };
 
         int option_index = 0;
-        c = getopt_long (argc, argv, "hzlsHTcdtn:NEa:vAro:ORFD",
+        c = getopt_long (argc, argv, "hzlsHTcdtn:NEa:g:vAro:ORFD",
                 long_options, &option_index);
 
         // Detect the end of the options.
@@ -188,6 +195,12 @@ int main_stats(int argc, char** argv) {
 
         case 'a':
             alignments_filename = optarg;
+            alignments_are_gaf = false;
+            break;
+
+        case 'g':
+            alignments_filename = optarg;
+            alignments_are_gaf = true;
             break;
 
         case 'r':
@@ -499,8 +512,10 @@ int main_stats(int argc, char** argv) {
     }
 
     if (!alignments_filename.empty()) {
-        // Read in the given GAM
-        ifstream alignment_stream(alignments_filename);
+        if (alignments_are_gaf) {
+            // We need node lengths and sequences to read GAF
+            require_graph();
+        }
 
         // We need some allele parsing functions
 
@@ -528,9 +543,6 @@ int main_stats(int argc, char** argv) {
             size_t total_perfect = 0; // Number of reads with no indels or substitutions relative to their paths
             size_t total_gapless = 0; // Number of reads with no indels relative to their paths
 
-            // These are for tracking which nodes are covered and which are not
-            map<vg::id_t, size_t> node_visit_counts;
-
             // And for counting indels
             // Inserted bases also counts softclips
             size_t total_insertions = 0;
@@ -565,10 +577,6 @@ int main_stats(int argc, char** argv) {
                 total_perfect += other.total_perfect;
                 total_gapless += other.total_gapless;
                 
-                for (auto& kv : other.node_visit_counts) {
-                    node_visit_counts[kv.first] += kv.second;
-                }
-                
                 total_insertions += other.total_insertions;
                 total_inserted_bases += other.total_inserted_bases;
                 total_deletions += other.total_deletions;
@@ -597,15 +605,34 @@ int main_stats(int argc, char** argv) {
         // Before we go over the reads, we need to make a map that tells us what
         // nodes are unique to what allele paths. Stores site and allele parts
         // separately.
-        map<vg::id_t, pair<string, string>> allele_path_for_node;
+        unordered_map<vg::id_t, pair<string, string>> allele_path_for_node;
+        
+        // These are for tracking which nodes are covered and which are not.
+        // All threads count visits here, indexed by node ID offset from the
+        // graph's min ID. We only need to tell 0, 1, and more visits apart, so
+        // counts stop going up at 2 (give or take a few racing threads).
+        vg::id_t visit_min_id = 0;
+        vector<atomic<uint8_t>> node_visits;
 
         // Create a combined ReadStats accumulator. We need to pre-populate its
         // reads_on_allele with 0s when we look at the alleles so we know which
         // sites actually have 2 alleles and which only have 1 in the graph.
         ReadStats combined;
 
+        // Allocate per-thread storage for stats
+        size_t thread_count = get_thread_count();
+
         if (graph.get() != nullptr) {
             // We have a graph to work on
+            
+            visit_min_id = graph->min_node_id();
+            node_visits = vector<atomic<uint8_t>>(graph->max_node_id() - visit_min_id + 1);
+            for (auto& visits : node_visits) {
+                visits.store(0, memory_order_relaxed);
+            }
+            
+            // Collect the unique allele nodes per thread, to merge after
+            vector<vector<pair<vg::id_t, pair<string, string>>>> thread_allele_nodes(thread_count);
 
             // For each pair of allele paths in the graph, we need to find out
             // whether the coverage imbalance between them among primary alignments
@@ -657,16 +684,17 @@ int main_stats(int argc, char** argv) {
                 auto allele = path_name_to_allele(allele_path);
 
 
-                #pragma omp critical (allele_path_for_node)
-                allele_path_for_node[graph->get_id(node)] = make_pair(site, allele);
-
-                #pragma omp critical (reads_on_allele)
-                combined.reads_on_allele[site][allele] = 0;
+                thread_allele_nodes[omp_get_thread_num()].emplace_back(graph->get_id(node), make_pair(site, allele));
             }, true);
+            
+            for (auto& allele_nodes : thread_allele_nodes) {
+                for (auto& node_and_allele : allele_nodes) {
+                    combined.reads_on_allele[node_and_allele.second.first][node_and_allele.second.second] = 0;
+                    allele_path_for_node.emplace(node_and_allele.first, std::move(node_and_allele.second));
+                }
+            }
         }
 
-        // Allocate per-thread storage for stats
-        size_t thread_count = get_thread_count();
         vector<ReadStats> read_stats;
         read_stats.resize(thread_count); 
 
@@ -705,15 +733,21 @@ int main_stats(int argc, char** argv) {
                     auto& mapping = aln.path().mapping(i);
                     vg::id_t node_id = mapping.position().node_id();
 
-                    if(allele_path_for_node.count(node_id)) {
+                    auto found = allele_path_for_node.find(node_id);
+                    if(found != allele_path_for_node.end()) {
                         // We hit a unique node for this allele. Add it to the set,
                         // in case we hit another unique node for it later in the
                         // read.
-                        alleles_supported.insert(allele_path_for_node.at(node_id));
+                        alleles_supported.insert(found->second);
                     }
 
                     // Record that there was a visit to this node.
-                    stats.node_visit_counts[node_id]++;
+                    if (node_id >= visit_min_id && node_id - visit_min_id < (vg::id_t) node_visits.size()) {
+                        auto& visits = node_visits[node_id - visit_min_id];
+                        if (visits.load(memory_order_relaxed) < 2) {
+                            visits.fetch_add(1, memory_order_relaxed);
+                        }
+                    }
 
                     for(size_t j = 0; j < mapping.edit_size(); j++) {
                         // Go through edits and look for each type.
@@ -791,7 +825,13 @@ int main_stats(int argc, char** argv) {
         };
 
         // Actually go through all the reads and count stuff up.
-        vg::io::for_each_parallel(alignment_stream, lambda);
+        if (alignments_are_gaf) {
+            vg::io::gaf_unpaired_for_each_parallel(*graph, alignments_filename, lambda);
+        } else {
+            get_input_file(alignments_filename, [&](istream& alignment_stream) {
+                vg::io::for_each_parallel(alignment_stream, lambda);
+            });
+        }
         
         // Now combine into a single ReadStats object (for which we pre-populated reads_on_allele with 0s).
         for (auto& per_thread : read_stats) {
@@ -870,24 +910,20 @@ int main_stats(int argc, char** argv) {
                 nid_t id = graph->get_id(node);
                 size_t length = graph->get_length(node);
                 
-                if(!combined.node_visit_counts.count(id) || combined.node_visit_counts.at(id) == 0) {
+                uint8_t visits = node_visits[id - visit_min_id].load(memory_order_relaxed);
+                
+                if(visits == 0) {
                     // If we never visited it with a read, count it.
-                    #pragma omp critical (unvisited_nodes)
                     unvisited_nodes++;
-                    #pragma omp critical (unvisited_node_bases)
                     unvisited_node_bases += length;
                     if(verbose) {
-                        #pragma omp critical (unvisited_ids)
                         unvisited_ids.insert(id);
                     }
-                } else if(combined.node_visit_counts.at(id) == 1) {
+                } else if(visits == 1) {
                     // If we visited it with only one read, count it.
-                    #pragma omp critical (single_visited_nodes)
                     single_visited_nodes++;
-                    #pragma omp critical (single_visited_node_bases)
                     single_visited_node_bases += length;
                     if(verbose) {
-                        #pragma omp critical (single_visited_ids)
                         single_visited_ids.insert(id);
                     }
                 }
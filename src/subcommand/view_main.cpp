@@ -36,6 +36,7 @@ void help_view(char** argv) {
          << "options:" << endl
          << "    -g, --gfa                  output GFA format (default)" << endl
          << "    -F, --gfa-in               input GFA format, reducing overlaps if they occur" << endl
+         << "    --gfa-bgzip                compress GFA output with BGZF" << endl
 
          << "    -v, --vg                   output VG format" << endl
          << "    -V, --vg-in                input VG format only" << endl
@@ -142,6 +143,7 @@ int main_view(int argc, char** argv) {
     bool expect_duplicates = false;
     string extract_tag;
     bool ascii_labels = false;
+    bool gfa_bgzip = false;
     omp_set_num_threads(1); // default to 1 thread
 
     int c;
@@ -195,6 +197,7 @@ int main_view(int argc, char** argv) {
                 {"multipath-in", no_argument, 0, 'K'},
                 {"ascii-labels", no_argument, 0, 'e'},
                 {"threads", required_argument, 0, '7'},
+                {"gfa-bgzip", no_argument, 0, '8'},
                 {0, 0, 0, 0}
             };
 
@@ -425,6 +428,10 @@ int main_view(int argc, char** argv) {
             omp_set_num_threads(parse<int>(optarg));
             break;
 
+        case '8':
+            gfa_bgzip = true;
+            break;
+
         case 'h':
         case '?':
             /* getopt_long already printed an error message. */
@@ -894,7 +901,7 @@ int main_view(int argc, char** argv) {
     }
 
     if (output_type == "gfa") {
-        graph_to_gfa(graph, std::cout);
+        graph_to_gfa(graph, std::cout, gfa_bgzip);
         return 0;
     } 
 
@@ -1,5 +1,6 @@
 
 #include <thread>
+#include <atomic>
 
 #include "../io/save_handle_graph.hpp"
 
@@ -431,8 +432,8 @@ void Transcriptome::reorder_exons(Transcript * transcript) const {
 
 list<EditedTranscriptPath> Transcriptome::construct_edited_transcript_paths(const vector<Transcript> & transcripts, const bdsg::PositionOverlay & graph_path_pos_overlay) const {
 
-    list<EditedTranscriptPath> edited_transcript_paths;
-    mutex edited_transcript_paths_mutex;
+    // Each thread writes to its own list, so no locking is needed.
+    vector<list<EditedTranscriptPath> > thread_edited_transcript_paths(num_threads);
 
     vector<thread> construction_threads;
     construction_threads.reserve(num_threads);
@@ -440,7 +441,7 @@ list<EditedTranscriptPath> Transcriptome::construct_edited_transcript_paths(cons
     // Spawn construction threads.
     for (size_t thread_idx = 0; thread_idx < num_threads; thread_idx++) {
 
-        construction_threads.push_back(thread(&Transcriptome::construct_edited_transcript_paths_callback, this, &edited_transcript_paths, &edited_transcript_paths_mutex, ref(graph_path_pos_overlay), thread_idx, ref(transcripts)));
+        construction_threads.push_back(thread(&Transcriptome::construct_edited_transcript_paths_callback, this, &(thread_edited_transcript_paths.at(thread_idx)), ref(graph_path_pos_overlay), thread_idx, ref(transcripts)));
     }
 
     // Join construction threads.   
@@ -449,12 +450,18 @@ list<EditedTranscriptPath> Transcriptome::construct_edited_transcript_paths(cons
         thread.join();
     }
 
+    // Merge thread results in thread order.
+    list<EditedTranscriptPath> edited_transcript_paths;
+
+    for (auto & edited_transcript_paths_thread: thread_edited_transcript_paths) {
+
+        edited_transcript_paths.splice(edited_transcript_paths.end(), edited_transcript_paths_thread);
+    }
+
     return edited_transcript_paths;
 }
 
-void Transcriptome::construct_edited_transcript_paths_callback(list<EditedTranscriptPath> * edited_transcript_paths, mutex * edited_transcript_paths_mutex, const bdsg::PositionOverlay & graph_path_pos_overlay, const int32_t thread_idx, const vector<Transcript> & transcripts) const {
-
-    list<EditedTranscriptPath> thread_edited_transcript_paths;
+void Transcriptome::construct_edited_transcript_paths_callback(list<EditedTranscriptPath> * thread_edited_transcript_paths, const bdsg::PositionOverlay & graph_path_pos_overlay, const int32_t thread_idx, const vector<Transcript> & transcripts) const {
 
     int32_t transcripts_idx = thread_idx;
 
@@ -470,9 +477,12 @@ void Transcriptome::construct_edited_transcript_paths_callback(list<EditedTransc
 
             assert(!new_edited_transcript_paths.front().reference_origin.empty());
 
-            thread_edited_transcript_paths.splice(thread_edited_transcript_paths.end(), new_edited_transcript_paths);
+            // Splicing keeps the elements in place, so the reference to the
+            // path stays valid after it has been moved to the thread list.
+            auto transcript_path_it = new_edited_transcript_paths.begin();
+            thread_edited_transcript_paths->splice(thread_edited_transcript_paths->end(), new_edited_transcript_paths);
 
-            Path & transcript_path = new_edited_transcript_paths.front().path;
+            const Path & transcript_path = transcript_path_it->path;
 
             // Add adjecent same node exons as single paths to ensure boundary breaking
             for (size_t i = 1; i < transcript_path.mapping_size(); ++i) {
@@ -485,29 +495,28 @@ void Transcriptome::construct_edited_transcript_paths_callback(list<EditedTransc
                     (*exon_path_left.path.add_mapping()) = transcript_path.mapping(i - 1);
                     (*exon_path_right.path.add_mapping()) = transcript_path.mapping(i);
 
-                    thread_edited_transcript_paths.emplace_back(exon_path_left);
-                    thread_edited_transcript_paths.emplace_back(exon_path_right);
+                    thread_edited_transcript_paths->emplace_back(exon_path_left);
+                    thread_edited_transcript_paths->emplace_back(exon_path_right);
                 }
             }
         }
 
         transcripts_idx += num_threads;
     }
-
-    edited_transcript_paths_mutex->lock();
-    edited_transcript_paths->splice(edited_transcript_paths->end(), thread_edited_transcript_paths);
-    edited_transcript_paths_mutex->unlock();
 }
 
 void Transcriptome::project_and_add_transcripts(const vector<Transcript> & transcripts, const gbwt::GBWT & haplotype_index, const bdsg::PositionOverlay & graph_path_pos_overlay, const float mean_node_length) {
 
+    // Each thread writes to its own contiguous vector, so no locking is needed.
+    vector<vector<CompletedTranscriptPath> > thread_completed_transcript_paths(num_threads);
+
     vector<thread> projection_threads;
     projection_threads.reserve(num_threads);
 
     // Spawn projection threads.
     for (size_t thread_idx = 0; thread_idx < num_threads; thread_idx++) {
 
-        projection_threads.push_back(thread(&Transcriptome::project_and_add_transcripts_callback, this, thread_idx, ref(transcripts), ref(haplotype_index), ref(graph_path_pos_overlay), mean_node_length));
+        projection_threads.push_back(thread(&Transcriptome::project_and_add_transcripts_callback, this, &(thread_completed_transcript_paths.at(thread_idx)), thread_idx, ref(transcripts), ref(haplotype_index), ref(graph_path_pos_overlay), mean_node_length));
     }
 
     // Join projection threads.   
@@ -515,11 +524,30 @@ void Transcriptome::project_and_add_transcripts(const vector<Transcript> & trans
         
         thread.join();
     }
-}
 
-void Transcriptome::project_and_add_transcripts_callback(const int32_t thread_idx, const vector<Transcript> & transcripts, const gbwt::GBWT & haplotype_index, const bdsg::PositionOverlay & graph_path_pos_overlay, const float mean_node_length) {
+    size_t num_new_transcript_paths = 0;
+
+    for (auto & completed_transcript_paths: thread_completed_transcript_paths) {
+
+        num_new_transcript_paths += completed_transcript_paths.size();
+    }
+
+    // Add transcript paths to transcriptome in thread order.
+    _transcript_paths.reserve(_transcript_paths.size() + num_new_transcript_paths);
+
+    for (auto & completed_transcript_paths: thread_completed_transcript_paths) {
 
-    list<CompletedTranscriptPath> thread_completed_transcript_paths;
+        for (auto & transcript_path: completed_transcript_paths) {
+
+            _transcript_paths.emplace_back(move(transcript_path));
+        }
+
+        completed_transcript_paths.clear();
+        completed_transcript_paths.shrink_to_fit();
+    }
+}
+
+void Transcriptome::project_and_add_transcripts_callback(vector<CompletedTranscriptPath> * thread_completed_transcript_paths, const int32_t thread_idx, const vector<Transcript> & transcripts, const gbwt::GBWT & haplotype_index, const bdsg::PositionOverlay & graph_path_pos_overlay, const float mean_node_length) const {
 
     int32_t transcripts_idx = thread_idx;
 
@@ -528,7 +556,7 @@ void Transcriptome::project_and_add_transcripts_callback(const int32_t thread_id
         // Get next transcript belonging to current thread.
         const Transcript & transcript = transcripts.at(transcripts_idx);
 
-        list<CompletedTranscriptPath> completed_transcript_paths;
+        vector<CompletedTranscriptPath> completed_transcript_paths;
 
         if (!haplotype_index.empty()) { 
 
@@ -545,41 +573,27 @@ void Transcriptome::project_and_add_transcripts_callback(const int32_t thread_id
             append_transcript_paths(&completed_transcript_paths, &new_completed_transcript_paths, collapse_transcript_paths);
         }
 
-        auto thread_completed_transcript_paths_it = completed_transcript_paths.begin();
         int32_t transcript_path_idx = 1;
 
-        while (thread_completed_transcript_paths_it != completed_transcript_paths.end()) {
+        for (auto & completed_transcript_path: completed_transcript_paths) {
 
             // Set transcript path name. The name contains the original transcript name/id 
             // and a unique index for each non-reference transcript copy.
-            if (thread_completed_transcript_paths_it->reference_origin.empty()) {
+            if (completed_transcript_path.reference_origin.empty()) {
 
-                thread_completed_transcript_paths_it->name = thread_completed_transcript_paths_it->transcript_origin + "_" + to_string(transcript_path_idx);
+                completed_transcript_path.name = completed_transcript_path.transcript_origin + "_" + to_string(transcript_path_idx);
                 ++transcript_path_idx;
 
             } else {
 
-                thread_completed_transcript_paths_it->name = thread_completed_transcript_paths_it->transcript_origin;                
+                completed_transcript_path.name = completed_transcript_path.transcript_origin;                
             }
 
-            ++thread_completed_transcript_paths_it;
+            thread_completed_transcript_paths->emplace_back(move(completed_transcript_path));
         }
 
-        thread_completed_transcript_paths.splice(thread_completed_transcript_paths.end(), completed_transcript_paths);
         transcripts_idx += num_threads;
     }
-
-    // Add transcript paths to transcriptome.
-    mutex_transcript_paths.lock();
-
-    _transcript_paths.reserve(_transcript_paths.size() + thread_completed_transcript_paths.size());
-
-    for (auto & transcript_path: thread_completed_transcript_paths) {
-
-        _transcript_paths.emplace_back(move(transcript_path));
-    }
-
-    mutex_transcript_paths.unlock();
 }
 
 list<EditedTranscriptPath> Transcriptome::project_transcript_gbwt(const Transcript & cur_transcript, const gbwt::GBWT & haplotype_index, const float mean_node_length) const {
@@ -1216,66 +1230,80 @@ list<EditedTranscriptPath> Transcriptome::project_transcript_embedded(const Tran
     return edited_transcript_paths;
 }
 
-void Transcriptome::append_transcript_paths(list<CompletedTranscriptPath> * completed_transcript_paths, list<CompletedTranscriptPath> * new_completed_transcript_paths, const bool add_unqiue_paths_only) const {
+void Transcriptome::append_transcript_paths(vector<CompletedTranscriptPath> * completed_transcript_paths, vector<CompletedTranscriptPath> * new_completed_transcript_paths, const bool add_unqiue_paths_only) const {
+
+    completed_transcript_paths->reserve(completed_transcript_paths->size() + new_completed_transcript_paths->size());
 
     // Add only non unique transcript paths.
     if (add_unqiue_paths_only) {
 
+        // Index current transcript paths by their handles, so that 
+        // duplicates are found without comparing against every path.
+        unordered_map<vector<handle_t>, size_t, HandlePathHash> completed_transcript_path_index;
+        completed_transcript_path_index.reserve(completed_transcript_paths->size() + new_completed_transcript_paths->size());
+
+        for (size_t i = 0; i < completed_transcript_paths->size(); ++i) {
+
+            completed_transcript_path_index.emplace(completed_transcript_paths->at(i).path, i);
+        }
+
         for (auto & new_completed_transcript_path: *new_completed_transcript_paths) {
 
-            bool new_path_unqiue = true;
+            auto completed_transcript_path_index_it = completed_transcript_path_index.find(new_completed_transcript_path.path);
 
-            for (auto & completed_transcript_path: *completed_transcript_paths) {
+            // Check if an identical path exists.
+            if (completed_transcript_path_index_it != completed_transcript_path_index.end()) {
 
-                // Check if two paths are identical.
-                if (completed_transcript_path.path == new_completed_transcript_path.path) {
+                auto & completed_transcript_path = completed_transcript_paths->at(completed_transcript_path_index_it->second);
 
-                    if (completed_transcript_path.transcript_origin != new_completed_transcript_path.transcript_origin) {
+                if (completed_transcript_path.transcript_origin != new_completed_transcript_path.transcript_origin) {
 
-                        cerr << "[transcriptome] WARNING: Different transcripts collaped (" << completed_transcript_path.transcript_origin << " & " << new_completed_transcript_path.transcript_origin << ")" << endl;
-                    }
+                    cerr << "[transcriptome] WARNING: Different transcripts collaped (" << completed_transcript_path.transcript_origin << " & " << new_completed_transcript_path.transcript_origin << ")" << endl;
+                }
 
-                    assert(completed_transcript_path.reference_origin == new_completed_transcript_path.reference_origin || completed_transcript_path.reference_origin.empty() || new_completed_transcript_path.reference_origin.empty());
+                assert(completed_transcript_path.reference_origin == new_completed_transcript_path.reference_origin || completed_transcript_path.reference_origin.empty() || new_completed_transcript_path.reference_origin.empty());
 
-                    // Merge reference origin name.
-                    if (completed_transcript_path.reference_origin.empty()) {
+                // Merge reference origin name.
+                if (completed_transcript_path.reference_origin.empty()) {
 
-                        completed_transcript_path.reference_origin = new_completed_transcript_path.reference_origin;
-                    }
+                    completed_transcript_path.reference_origin = new_completed_transcript_path.reference_origin;
+                }
 
-                    // Merge haplotype origin ids.
-                    completed_transcript_path.haplotype_origin_ids.insert(completed_transcript_path.haplotype_origin_ids.end(), new_completed_transcript_path.haplotype_origin_ids.begin(), new_completed_transcript_path.haplotype_origin_ids.end());
+                // Merge haplotype origin ids.
+                completed_transcript_path.haplotype_origin_ids.insert(completed_transcript_path.haplotype_origin_ids.end(), new_completed_transcript_path.haplotype_origin_ids.begin(), new_completed_transcript_path.haplotype_origin_ids.end());
 
-                    // Merge embedded path origin names.
-                    if (completed_transcript_path.path_origin_names.empty()) {
+                // Merge embedded path origin names.
+                if (completed_transcript_path.path_origin_names.empty()) {
 
-                        completed_transcript_path.path_origin_names = new_completed_transcript_path.path_origin_names;
+                    completed_transcript_path.path_origin_names = new_completed_transcript_path.path_origin_names;
 
-                    } else if (!new_completed_transcript_path.path_origin_names.empty()) {
+                } else if (!new_completed_transcript_path.path_origin_names.empty()) {
 
-                        completed_transcript_path.path_origin_names.append("," + new_completed_transcript_path.path_origin_names);
-                    }
-                    
-                    new_path_unqiue = false;
-                    break;
+                    completed_transcript_path.path_origin_names.append("," + new_completed_transcript_path.path_origin_names);
                 }
-            }
 
-            if (new_path_unqiue) {
+            } else {
 
-                completed_transcript_paths->push_back(new_completed_transcript_path);
+                completed_transcript_path_index.emplace(new_completed_transcript_path.path, completed_transcript_paths->size());
+                completed_transcript_paths->emplace_back(move(new_completed_transcript_path));
             } 
         }
     
     } else {
 
-        completed_transcript_paths->splice(completed_transcript_paths->end(), *new_completed_transcript_paths);
+        for (auto & new_completed_transcript_path: *new_completed_transcript_paths) {
+
+            completed_transcript_paths->emplace_back(move(new_completed_transcript_path));
+        }
     }
+
+    new_completed_transcript_paths->clear();
 }
 
-list<CompletedTranscriptPath> Transcriptome::construct_completed_transcript_paths(const list<EditedTranscriptPath> & edited_transcript_paths) const {
+vector<CompletedTranscriptPath> Transcriptome::construct_completed_transcript_paths(const list<EditedTranscriptPath> & edited_transcript_paths) const {
 
-    list<CompletedTranscriptPath> completed_transcript_paths;
+    vector<CompletedTranscriptPath> completed_transcript_paths;
+    completed_transcript_paths.reserve(edited_transcript_paths.size());
 
     for (auto & transcript_path: edited_transcript_paths) {
 
@@ -1365,33 +1393,49 @@ void Transcriptome::augment_splice_graph(list<EditedTranscriptPath> * edited_tra
         edited_paths.emplace_back(move(transcript_path.path));
     }
 
-    if (haplotype_index->empty()) {
-
-        // Augment splice graph with edited paths. 
-        augment(static_cast<MutablePathMutableHandleGraph *>(_splice_graph.get()), edited_paths, "GAM", nullptr, "", false, break_at_transcript_ends);
-      
-    } else {
-
-        vector<Translation> translations;
+    // Start positions of the pieces of split nodes. This is much 
+    // smaller than the full translation of the graph.
+    map<pos_t, id_t> node_translation;
 
 #ifdef transcriptome_debug
     double time_edit_1 = gcsa::readTimer();
     cerr << "\tDEBUG edit start: " << gcsa::inGigabytes(gcsa::memoryUsage()) << " GB" << endl;
 #endif
 
-        // Augment splice graph with edited paths. 
-        augment(static_cast<MutablePathMutableHandleGraph *>(_splice_graph.get()), edited_paths, "GAM", &translations, "", false, break_at_transcript_ends);
+    // Augment splice graph with edited paths. 
+    augment(static_cast<MutablePathMutableHandleGraph *>(_splice_graph.get()), edited_paths, "GAM", nullptr, "", false, break_at_transcript_ends, false, false, 0, 0, nullptr, 0, 1, &node_translation);
 
 #ifdef transcriptome_debug
     cerr << "\tDEBUG edit end: " << gcsa::readTimer() - time_edit_1 << " seconds, " << gcsa::inGigabytes(gcsa::memoryUsage()) << " GB" << endl;
 #endif 
 
+    // Remember where split nodes ended up, so that the 
+    // graph order can be restored locally.
+    record_split_nodes(node_translation);
+
+    if (!haplotype_index->empty()) {
+
         // Update threads in gbwt index to match new augmented graph.
-        update_haplotype_index(haplotype_index, translations);
+        update_haplotype_index(haplotype_index, node_translation);
+    }
+}
+
+void Transcriptome::record_split_nodes(const map<pos_t, id_t> & node_translation) {
+
+    for (auto & piece: node_translation) {
+
+        // Both strands are recorded, so the forward strand is enough. The 
+        // first piece keeps the original id and id 0 marks the node end.
+        if (is_rev(piece.first) || piece.second == 0 || piece.second == id(piece.first)) {
+
+            continue;
+        }
+
+        _split_node_pieces[id(piece.first)].emplace_back(offset(piece.first), piece.second);
     }
 }
 
-void Transcriptome::update_haplotype_index(unique_ptr<gbwt::GBWT> & haplotype_index, const vector<Translation> & translations) const {
+void Transcriptome::update_haplotype_index(unique_ptr<gbwt::GBWT> & haplotype_index, const map<pos_t, id_t> & node_translation) const {
 
 #ifdef transcriptome_debug
     double time_translation_1 = gcsa::readTimer();
@@ -1401,20 +1445,22 @@ void Transcriptome::update_haplotype_index(unique_ptr<gbwt::GBWT> & haplotype_in
     unordered_map<gbwt::node_type, vector<pair<int32_t, gbwt::node_type> > > translation_index;
 
     // Create translation index 
-    for (auto & translation: translations) {
-
-        assert(translation.from().mapping_size() == 1);
-        assert(translation.to().mapping_size() == 1);
-
-        auto & from_mapping = translation.from().mapping(0);
-        auto & to_mapping = translation.to().mapping(0);
+    for (auto & piece: node_translation) {
 
         // Only store changes
-        if (!google::protobuf::util::MessageDifferencer::Equals(from_mapping, to_mapping)) {
+        if (piece.second == 0 || (piece.second == id(piece.first) && offset(piece.first) == 0)) {
 
-            auto translation_index_it = translation_index.emplace(mapping_to_gbwt(from_mapping), vector<pair<int32_t, gbwt::node_type> >());
-            translation_index_it.first->second.emplace_back(from_mapping.position().offset(), mapping_to_gbwt(to_mapping));
+            continue;
         }
+
+        auto translation_index_it = translation_index.emplace(pos_to_gbwt(piece.first), vector<pair<int32_t, gbwt::node_type> >());
+        translation_index_it.first->second.emplace_back(offset(piece.first), gbwt::Node::encode(piece.second, is_rev(piece.first)));
+    }
+
+    // No nodes were split, so the threads are already valid.
+    if (translation_index.empty()) {
+
+        return;
     }
 
     // Sort translation index by offset
@@ -1594,10 +1640,135 @@ void Transcriptome::remove_non_transcribed(const bool new_reference_paths) {
     assert(_splice_graph->get_node_count() == transcribed_nodes.size());
 }
 
-void Transcriptome::compact_ordered() {
+bool Transcriptome::compact_ordered() {
 
     assert(_transcript_paths.empty());
-    _splice_graph->apply_ordering(handlealgs::topological_order(_splice_graph.get()), true);
+
+    vector<handle_t> local_order;
+    bool is_local = local_topological_order(&local_order);
+
+    if (is_local) {
+
+        _splice_graph->apply_ordering(local_order, true);
+
+    } else {
+
+        _splice_graph->apply_ordering(handlealgs::topological_order(_splice_graph.get()), true);
+    }
+
+    // Node ids have been compacted. 
+    _split_node_pieces.clear();
+
+    return is_local;
+}
+
+bool Transcriptome::local_topological_order(vector<handle_t> * order) const {
+
+    order->clear();
+
+    if (_splice_graph->get_node_count() == 0) {
+
+        return false;
+    }
+
+    unordered_set<nid_t> split_piece_ids;
+
+    for (auto & split_node: _split_node_pieces) {
+
+        for (auto & piece: split_node.second) {
+
+            split_piece_ids.emplace(piece.second);
+        }
+    }
+
+    // Nodes that were in the graph before augmentation keep their id order.
+    vector<nid_t> original_ids;
+    original_ids.reserve(_splice_graph->get_node_count() - split_piece_ids.size());
+
+    _splice_graph->for_each_handle([&](const handle_t & handle) {
+
+        auto node_id = _splice_graph->get_id(handle);
+
+        if (split_piece_ids.count(node_id) == 0) {
+
+            original_ids.emplace_back(node_id);
+        }
+    });
+
+    sort(original_ids.begin(), original_ids.end());
+    order->reserve(_splice_graph->get_node_count());
+
+    // Place the pieces of each split node directly after the node, 
+    // in offset order. Pieces can themselves have been split again.
+    for (auto & original_id: original_ids) {
+
+        vector<pair<nid_t, bool> > node_stack(1, make_pair(original_id, false));
+
+        while (!node_stack.empty()) {
+
+            auto node_id = node_stack.back().first;
+            auto is_expanded = node_stack.back().second;
+            node_stack.pop_back();
+
+            auto split_node_it = _split_node_pieces.find(node_id);
+
+            if (is_expanded || split_node_it == _split_node_pieces.end()) {
+
+                order->emplace_back(_splice_graph->get_handle(node_id, false));
+                continue;
+            }
+
+            auto pieces = split_node_it->second;
+            sort(pieces.begin(), pieces.end());
+
+            // Push pieces in reverse so that the node comes first.
+            for (auto pieces_rit = pieces.rbegin(); pieces_rit != pieces.rend(); ++pieces_rit) {
+
+                node_stack.emplace_back(pieces_rit->second, false);
+            }
+
+            node_stack.emplace_back(node_id, true);
+        }
+    }
+
+    if (order->size() != _splice_graph->get_node_count()) {
+
+        // Graph contains new nodes that are not pieces of split nodes.
+        return false;
+    }
+
+    auto min_node_id = _splice_graph->min_node_id();
+    vector<size_t> node_ranks(_splice_graph->max_node_id() - min_node_id + 1, 0);
+
+    for (size_t i = 0; i < order->size(); ++i) {
+
+        node_ranks.at(_splice_graph->get_id(order->at(i)) - min_node_id) = i;
+    }
+
+    // Check that all forward strand edges go forward in the order. If they 
+    // do not, the input graph was not sorted to begin with.
+    atomic<bool> is_ordered(true);
+
+    _splice_graph->for_each_handle([&](const handle_t & handle) {
+
+        if (!is_ordered.load()) {
+
+            return;
+        }
+
+        auto rank = node_ranks.at(_splice_graph->get_id(handle) - min_node_id);
+
+        _splice_graph->follow_edges(handle, false, [&](const handle_t & next) {
+
+            if (!_splice_graph->get_is_reverse(next) && node_ranks.at(_splice_graph->get_id(next) - min_node_id) <= rank) {
+
+                is_ordered.store(false);
+            }
+        });
+
+    }, true);
+
+    return is_ordered.load();
 }
 
 int32_t Transcriptome::embed_transcript_paths(const bool add_reference_paths, const bool add_non_reference_paths) {
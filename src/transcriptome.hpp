@@ -121,6 +121,24 @@ struct CompletedTranscriptPath : public TranscriptPath {
 
 
 
+/**
+ * Hash function for transcript paths represented as handle vectors.
+ */
+struct HandlePathHash {
+
+    size_t operator()(const vector<handle_t> & handle_path) const {
+
+        size_t seed = handle_path.size();
+
+        for (auto & handle: handle_path) {
+
+            seed ^= std::hash<handle_t>()(handle) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+
+        return seed;
+    }
+};
+
 /**
  * Class that defines a transcriptome represented by a set of transcript paths.
  */
@@ -179,8 +197,11 @@ class Transcriptome {
         /// trancribed nodes and edges.
         void remove_non_transcribed(const bool new_reference_paths);
 
-        /// Topological sort and compact graph.
-        void compact_ordered();
+        /// Topological sort and compact graph. If the graph was sorted 
+        /// before augmentation, the order is restored locally by placing 
+        /// the pieces of split nodes after the original node, without 
+        /// sorting the whole graph. Returns true if the local order was used.
+        bool compact_ordered();
 
         /// Embeds transcript paths in spliced variation graph.  
         /// Returns number of paths embedded.
@@ -205,7 +226,6 @@ class Transcriptome {
 
         /// Transcriptome represented by a set of transcript paths. 
         vector<CompletedTranscriptPath> _transcript_paths;
-        mutex mutex_transcript_paths;
 
         /// Spliced variation graph.
         unique_ptr<MutablePathDeletableHandleGraph> _splice_graph;
@@ -215,6 +235,11 @@ class Transcriptome {
         /// updated (e.g. split) since parsed.
         bool _splice_graph_node_updated;
 
+        /// Pieces (offset and node id) that nodes have been split 
+        /// into by augmentation since the graph was last compacted. 
+        /// The first piece keeps the original node id and is not stored.
+        unordered_map<nid_t, vector<pair<int64_t, nid_t> > > _split_node_pieces;
+
         /// Parse BED file of introns.
         vector<Transcript> parse_introns(istream & intron_stream, const bdsg::PositionOverlay & graph_path_pos_overlay) const;
 
@@ -236,15 +261,17 @@ class Transcriptome {
         /// reference transcripts. 
         list<EditedTranscriptPath> construct_edited_transcript_paths(const vector<Transcript> & transcripts, const bdsg::PositionOverlay & graph_path_pos_overlay) const;
 
-        /// Threaded edited transcript path construction.
-        void construct_edited_transcript_paths_callback(list<EditedTranscriptPath> * edited_transcript_paths, mutex * edited_transcript_paths_mutex, const bdsg::PositionOverlay & graph_path_pos_overlay, const int32_t thread_idx, const vector<Transcript> & transcripts) const;
+        /// Threaded edited transcript path construction. Adds
+        /// paths to a list owned by the thread.
+        void construct_edited_transcript_paths_callback(list<EditedTranscriptPath> * thread_edited_transcript_paths, const bdsg::PositionOverlay & graph_path_pos_overlay, const int32_t thread_idx, const vector<Transcript> & transcripts) const;
 
         /// Constructs transcript paths by projecting transcripts onto embedded paths in
         /// a variation graph and/or haplotypes in a GBWT index. 
         void project_and_add_transcripts(const vector<Transcript> & transcripts, const gbwt::GBWT & haplotype_index, const bdsg::PositionOverlay & graph_path_pos_overlay, const float mean_node_length);
 
-        /// Threaded transcript projecting.
-        void project_and_add_transcripts_callback(const int32_t thread_idx, const vector<Transcript> & transcripts, const gbwt::GBWT & haplotype_index, const bdsg::PositionOverlay & graph_path_pos_overlay, const float mean_node_length);
+        /// Threaded transcript projecting. Adds paths to a
+        /// vector owned by the thread.
+        void project_and_add_transcripts_callback(vector<CompletedTranscriptPath> * thread_completed_transcript_paths, const int32_t thread_idx, const vector<Transcript> & transcripts, const gbwt::GBWT & haplotype_index, const bdsg::PositionOverlay & graph_path_pos_overlay, const float mean_node_length) const;
 
         /// Projects transcripts onto haplotypes in a GBWT index and returns resulting transcript paths.
         list<EditedTranscriptPath> project_transcript_gbwt(const Transcript & cur_transcript, const gbwt::GBWT & haplotype_index, const float mean_node_length) const;
@@ -256,13 +283,14 @@ class Transcriptome {
         /// Projects transcripts onto embedded paths in a variation graph and returns resulting transcript paths.
         list<EditedTranscriptPath> project_transcript_embedded(const Transcript & cur_transcript, const bdsg::PositionOverlay & graph_path_pos_overlay, const bool reference_only) const;
 
-        /// Adds new transcript paths to current set. Has argument to only add unique paths.
-        void append_transcript_paths(list<CompletedTranscriptPath> * completed_transcript_path, list<CompletedTranscriptPath> * new_completed_transcript_paths, const bool add_unqiue_paths_only) const;
+        /// Adds new transcript paths to current set. Has argument to only add unique paths,
+        /// in which case identical paths are found using a hash table and merged.
+        void append_transcript_paths(vector<CompletedTranscriptPath> * completed_transcript_path, vector<CompletedTranscriptPath> * new_completed_transcript_paths, const bool add_unqiue_paths_only) const;
 
         /// Constructs completed transcripts paths from 
         /// edited transcript paths. Checks that the
         /// paths contain no edits compared to the graph.
-        list<CompletedTranscriptPath> construct_completed_transcript_paths(const list<EditedTranscriptPath> & edited_transcript_paths) const;
+        vector<CompletedTranscriptPath> construct_completed_transcript_paths(const list<EditedTranscriptPath> & edited_transcript_paths) const;
 
         /// Convert a path to a vector of handles. Checks that 
         /// the path is complete (i.e. only consist of whole nodes).
@@ -276,8 +304,18 @@ class Transcriptome {
         /// splice-junctions. Updates threads in gbwt index to match the augmented graph. 
         void augment_splice_graph(list<EditedTranscriptPath> * edited_transcript_paths, unique_ptr<gbwt::GBWT> & haplotype_index, const bool break_at_transcript_ends);
 
-        /// Update threads in gbwt index using graph translations. 
-        void update_haplotype_index(unique_ptr<gbwt::GBWT> & haplotype_index, const vector<Translation> & translation) const;
+        /// Records the pieces of nodes split by augmentation, given the 
+        /// start positions of the pieces on the original nodes.
+        void record_split_nodes(const map<pos_t, id_t> & node_translation);
+
+        /// Finds a topological order of the splice graph that keeps the 
+        /// id order of the graph before augmentation, with split nodes  
+        /// replaced by their pieces. Returns false if no such order exists.
+        bool local_topological_order(vector<handle_t> * order) const;
+
+        /// Update threads in gbwt index using the start positions of the
+        /// pieces of nodes split by augmentation. 
+        void update_haplotype_index(unique_ptr<gbwt::GBWT> & haplotype_index, const map<pos_t, id_t> & node_translation) const;
 
         /// Adds transcript path splice-junction edges to splice graph
         void add_splice_junction_edges(const list<EditedTranscriptPath> & edited_transcript_paths);
@@ -554,4 +554,68 @@ size_t CachedPackedTraversalSupportFinder::get_avg_node_mapq(id_t node) const {
     
 }
 
+
+DensePackedTraversalSupportFinder::DensePackedTraversalSupportFinder(const Packer& packer, SnarlManager& snarl_manager) :
+    PackedTraversalSupportFinder(packer, snarl_manager) {
+
+    // edge indexes can be used as is
+    edge_support_table.resize(packer.edge_vector_size());
+#pragma omp parallel for schedule(static, 4096)
+    for (size_t i = 0; i < edge_support_table.size(); ++i) {
+        edge_support_table[i] = packer.edge_coverage(i);
+    }
+
+    // node ranks are 1-based, so slot 0 is left as 0
+    // (only look at what the pack actually recorded)
+    size_t node_count = graph.get_node_count();
+    bool has_bases = packer.coverage_size() > 0;
+    bool has_qualities = packer.node_quality_vector_size() > node_count;
+    min_node_support_table.resize(node_count + 1, 0);
+    avg_node_support_table.resize(node_count + 1, 0);
+    avg_node_mapq_table.resize(node_count + 1, 0);
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (size_t rank = 1; rank <= node_count; ++rank) {
+        nid_t node = packer.index_to_node(rank);
+        if (has_bases) {
+            min_node_support_table[rank] = PackedTraversalSupportFinder::get_min_node_support(node).forward();
+            avg_node_support_table[rank] = PackedTraversalSupportFinder::get_avg_node_support(node).forward();
+        }
+        if (has_qualities) {
+            avg_node_mapq_table[rank] = PackedTraversalSupportFinder::get_avg_node_mapq(node);
+        }
+    }
+}
+
+DensePackedTraversalSupportFinder::~DensePackedTraversalSupportFinder() {
+}
+
+Support DensePackedTraversalSupportFinder::get_edge_support(id_t from, bool from_reverse,
+                                                            id_t to, bool to_reverse) const {
+    Edge proto_edge;
+    proto_edge.set_from(from);
+    proto_edge.set_from_start(from_reverse);
+    proto_edge.set_to(to);
+    proto_edge.set_to_end(to_reverse);
+    size_t edge_index = packer.edge_index(proto_edge);
+    Support support;
+    support.set_forward(edge_index < edge_support_table.size() ? edge_support_table[edge_index] : 0);
+    return support;
+}
+
+Support DensePackedTraversalSupportFinder::get_min_node_support(id_t node) const {
+    Support support;
+    support.set_forward(min_node_support_table[packer.node_index(node)]);
+    return support;
+}
+
+Support DensePackedTraversalSupportFinder::get_avg_node_support(id_t node) const {
+    Support support;
+    support.set_forward(avg_node_support_table[packer.node_index(node)]);
+    return support;
+}
+
+size_t DensePackedTraversalSupportFinder::get_avg_node_mapq(id_t node) const {
+    return avg_node_mapq_table[packer.node_index(node)];
+}
+
 }
@@ -172,6 +172,41 @@ protected:
     mutable vector<LRUCache<nid_t, size_t>*> avg_node_mapq_cache;
 };
 
+/**
+ * Summarize the Packer once, up front, into flat per-node and per-edge tables
+ * indexed by Packer::node_index() and Packer::edge_index().  Lookups are then
+ * O(1) array reads with no per-thread caches and no base-by-base decoding of
+ * the compressed coverage.  Returns the same values as PackedTraversalSupportFinder.
+ */
+class DensePackedTraversalSupportFinder : public PackedTraversalSupportFinder {
+public:
+    /// Build the tables in parallel using the current OMP thread count
+    DensePackedTraversalSupportFinder(const Packer& packer, SnarlManager& snarl_manager);
+    virtual ~DensePackedTraversalSupportFinder();
+
+    /// Support of an edge
+    virtual Support get_edge_support(id_t from, bool from_reverse, id_t to, bool to_reverse) const;
+    
+    /// Minimum support of a node
+    virtual Support get_min_node_support(id_t node) const;
+
+    /// Average support of a node
+    virtual Support get_avg_node_support(id_t node) const;
+
+    /// Average MAPQ of reads that map to a node
+    virtual size_t get_avg_node_mapq(id_t node) const;
+
+protected:
+
+    /// Edge coverage, by edge index
+    vector<size_t> edge_support_table;
+    /// Minimum base coverage, by node rank
+    vector<size_t> min_node_support_table;
+    /// Average base coverage, by node rank
+    vector<double> avg_node_support_table;
+    /// Average MAPQ, by node rank
+    vector<size_t> avg_node_mapq_table;
+};
 
 }
 
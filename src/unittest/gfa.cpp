@@ -3,6 +3,7 @@
 #include "../xg.hpp"
 #include "../gfa.hpp"
 #include "../algorithms/gfa_to_handle.hpp"
+#include "../algorithms/to_gfa.hpp"
 
 #include <bdsg/hash_graph.hpp>
 
@@ -369,6 +370,160 @@ L	1	+	0	+	0M)";
 
 }
 
+TEST_CASE("Loading a GFA from disk matches loading it from a stream", "[gfa]") {
+
+    const string graph_gfa = R"(H	VN:Z:1.0
+S	1	GATT
+S	2	ACA
+S	3	T
+L	1	+	2	+	0M
+L	2	+	3	-	*
+L	1	-	3	+	0M
+P	x	1+,2+,3-	*
+P	y	3+,1-	*)";
+    
+    string gfa_filename = temp_file::create();
+    {
+        ofstream gfa_out(gfa_filename);
+        gfa_out << graph_gfa << endl;
+    }
+    
+    bdsg::HashGraph streamed;
+    stringstream in(graph_gfa);
+    algorithms::gfa_to_path_handle_graph_in_memory(in, &streamed);
+    
+    bdsg::HashGraph mapped;
+    algorithms::gfa_to_path_handle_graph(gfa_filename, &mapped, true, true);
+    temp_file::remove(gfa_filename);
+    
+    REQUIRE(mapped.get_node_count() == streamed.get_node_count());
+    REQUIRE(mapped.get_edge_count() == streamed.get_edge_count());
+    REQUIRE(mapped.get_path_count() == streamed.get_path_count());
+    
+    streamed.for_each_handle([&](const handle_t& h) {
+        REQUIRE(mapped.has_node(streamed.get_id(h)));
+        REQUIRE(mapped.get_sequence(mapped.get_handle(streamed.get_id(h))) == streamed.get_sequence(h));
+    });
+    
+    streamed.for_each_edge([&](const edge_t& e) {
+        REQUIRE(mapped.has_edge(mapped.get_handle(streamed.get_id(e.first), streamed.get_is_reverse(e.first)),
+                                mapped.get_handle(streamed.get_id(e.second), streamed.get_is_reverse(e.second))));
+    });
+    
+    streamed.for_each_path_handle([&](const path_handle_t& p) {
+        string name = streamed.get_path_name(p);
+        REQUIRE(mapped.has_path(name));
+        vector<handle_t> expected;
+        for (handle_t h : streamed.scan_path(p)) {
+            expected.push_back(mapped.get_handle(streamed.get_id(h), streamed.get_is_reverse(h)));
+        }
+        vector<handle_t> found;
+        for (handle_t h : mapped.scan_path(mapped.get_path_handle(name))) {
+            found.push_back(h);
+        }
+        REQUIRE(found == expected);
+    });
+}
+
+TEST_CASE("Loading a GFA from disk keeps path circularity", "[gfa]") {
+
+    const string graph_gfa = R"(H	VN:Z:1.0
+S	1	GATT
+S	2	ACA
+L	1	+	2	+	0M
+L	2	+	1	+	0M
+P	circular	1+,2+	0M,0M
+P	linear	1+,2+	0M
+P	lengths	1+,2+	4M,3M)";
+    
+    string gfa_filename = temp_file::create();
+    {
+        ofstream gfa_out(gfa_filename);
+        gfa_out << graph_gfa << endl;
+    }
+    
+    bdsg::HashGraph mapped;
+    algorithms::gfa_to_path_handle_graph(gfa_filename, &mapped, true, true);
+    temp_file::remove(gfa_filename);
+    
+    REQUIRE(mapped.get_path_count() == 3);
+    REQUIRE(mapped.get_is_circular(mapped.get_path_handle("circular")));
+    REQUIRE(!mapped.get_is_circular(mapped.get_path_handle("linear")));
+    // vg has always written each step's length as its overlap
+    REQUIRE(!mapped.get_is_circular(mapped.get_path_handle("lengths")));
+    REQUIRE(mapped.get_step_count(mapped.get_path_handle("circular")) == 2);
+}
+
+TEST_CASE("Loading a GFA from disk rejects unsupported features", "[gfa]") {
+
+    const string graph_gfa = R"(H	VN:Z:1.0
+S	1	GATTAC
+S	2	ATTACA
+L	1	+	2	+	5M)";
+    
+    string gfa_filename = temp_file::create();
+    {
+        ofstream gfa_out(gfa_filename);
+        gfa_out << graph_gfa << endl;
+    }
+    
+    bdsg::HashGraph graph;
+    REQUIRE_THROWS_AS(algorithms::gfa_to_path_handle_graph(gfa_filename, &graph), algorithms::GFAFormatError);
+    temp_file::remove(gfa_filename);
+}
+
+TEST_CASE("GFA export writes every edge once and round-trips", "[gfa]") {
+
+    bdsg::HashGraph graph;
+    handle_t h1 = graph.create_handle("GATT");
+    handle_t h2 = graph.create_handle("ACA");
+    handle_t h3 = graph.create_handle("T");
+    graph.create_edge(h1, h2);
+    graph.create_edge(h2, graph.flip(h3));
+    graph.create_edge(graph.flip(h1), h3);
+    // self loops in each orientation
+    graph.create_edge(h3, h3);
+    graph.create_edge(h2, graph.flip(h2));
+    graph.create_edge(graph.flip(h1), h1);
+    
+    path_handle_t p = graph.create_path_handle("x");
+    graph.append_step(p, h1);
+    graph.append_step(p, h2);
+    graph.append_step(p, graph.flip(h3));
+    
+    stringstream out;
+    algorithms::to_gfa(graph, out);
+    
+    size_t link_lines = 0;
+    string line;
+    while (getline(out, line)) {
+        if (!line.empty() && line[0] == 'L') {
+            ++link_lines;
+        }
+    }
+    REQUIRE(link_lines == graph.get_edge_count());
+    
+    bdsg::HashGraph loaded;
+    stringstream in(out.str());
+    algorithms::gfa_to_path_handle_graph_in_memory(in, &loaded);
+    
+    REQUIRE(loaded.get_node_count() == graph.get_node_count());
+    REQUIRE(loaded.get_edge_count() == graph.get_edge_count());
+    graph.for_each_edge([&](const edge_t& e) {
+        REQUIRE(loaded.has_edge(loaded.get_handle(graph.get_id(e.first), graph.get_is_reverse(e.first)),
+                                loaded.get_handle(graph.get_id(e.second), graph.get_is_reverse(e.second))));
+    });
+    
+    REQUIRE(loaded.has_path("x"));
+    vector<handle_t> steps;
+    for (handle_t h : loaded.scan_path(loaded.get_path_handle("x"))) {
+        steps.push_back(h);
+    }
+    REQUIRE(steps.size() == 3);
+    REQUIRE(loaded.get_id(steps[2]) == graph.get_id(h3));
+    REQUIRE(loaded.get_is_reverse(steps[2]));
+}
+
 
         
 }
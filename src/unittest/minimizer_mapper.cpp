@@ -7,6 +7,7 @@
 #include <vg/vg.pb.h>
 #include "../minimizer_mapper.hpp"
 #include "../build_index.hpp"
+#include "../cactus_snarl_finder.hpp"
 #include "xg.hpp"
 #include "vg.hpp"
 #include "catch.hpp"
@@ -232,8 +233,14 @@ TEST_CASE("Fragment length distribution gets reasonable value", "[giraffe][mappi
 
 class TestableMinimizerMapper : public MinimizerMapper {
 public:
+    using MinimizerMapper::MinimizerMapper;
+    using MinimizerMapper::ChainItem;
+    using MinimizerMapper::chain_colinear;
     using MinimizerMapper::Minimizer;
     using MinimizerMapper::faster_cap;
+    using MinimizerMapper::for_each_agglomeration_interval;
+    using MinimizerMapper::get_log10_prob_of_disruption_in_interval;
+    using MinimizerMapper::get_prob_of_disruption_in_column;
 };
 
 TEST_CASE("Mapping quality cap cannot be confused by excessive Gs", "[giraffe][mapping]") {
@@ -298,9 +305,162 @@ TEST_CASE("Mapping quality cap cannot be confused by excessive Gs", "[giraffe][m
     REQUIRE(!std::isinf(cap));
 }
 
+TEST_CASE("Mapping quality cap intervals match the column-by-column computation exactly", "[giraffe][mapping]") {
+    // Make a 250bp read with varied qualities.
+    string sequence;
+    string quality;
+    size_t state = 12345;
+    auto next_random = [&]() -> size_t {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    };
+    for (size_t i = 0; i < 250; i++) {
+        sequence.push_back("ACGT"[next_random() % 4]);
+        quality.push_back((char)(2 + next_random() % 39));
+    }
+    
+    // Place overlapping minimizers on both strands, with their windows
+    // running off the ends of the read where necessary.
+    int core_width = 29;
+    int flank_width = 11;
+    vector<TestableMinimizerMapper::Minimizer> minimizers;
+    vector<size_t> minimizers_explored;
+    for (int core_start = 0; core_start + core_width <= sequence.size(); core_start += 3 + next_random() % 8) {
+        minimizers_explored.push_back(minimizers.size());
+        minimizers.emplace_back();
+        TestableMinimizerMapper::Minimizer& m = minimizers.back();
+        
+        m.agglomeration_start = max(0, core_start - flank_width);
+        m.agglomeration_length = min<int>(sequence.size(), core_start + core_width + flank_width) - m.agglomeration_start;
+        
+        m.value.key = gbwtgraph::DefaultMinimizerIndex::key_type::encode(sequence.substr(core_start, core_width));
+        m.value.hash = next_random() << 31 ^ next_random();
+        m.value.is_reverse = (next_random() % 2 == 0);
+        m.value.offset = m.value.is_reverse ? core_start + core_width - 1 : core_start;
+        
+        m.hits = 1;
+        m.occs = nullptr;
+        m.length = core_width;
+        m.candidates_per_window = flank_width + 1;
+        m.score = 1;
+    }
+    
+    std::sort(minimizers_explored.begin(), minimizers_explored.end(), [&](size_t a, size_t b) {
+        return minimizers[a].forward_offset() < minimizers[b].forward_offset();
+    });
+    
+    size_t intervals = 0;
+    TestableMinimizerMapper::for_each_agglomeration_interval(minimizers, sequence, quality, minimizers_explored,
+        [&](size_t left, size_t right, size_t bottom, size_t top) {
+        
+        auto disrupt_begin = minimizers_explored.begin() + bottom;
+        auto disrupt_end = minimizers_explored.begin() + top;
+        double fast = TestableMinimizerMapper::get_log10_prob_of_disruption_in_interval(minimizers, sequence, quality,
+            disrupt_begin, disrupt_end, left, right);
+        
+        // Combine the columns one at a time
+        double expected = 0;
+        if (left != right) {
+            double p = TestableMinimizerMapper::get_prob_of_disruption_in_column(minimizers, sequence, quality,
+                disrupt_begin, disrupt_end, left);
+            for (size_t i = left + 1; i < right; i++) {
+                double col_p = TestableMinimizerMapper::get_prob_of_disruption_in_column(minimizers, sequence, quality,
+                    disrupt_begin, disrupt_end, i);
+                p = (p + col_p - (p * col_p));
+            }
+            expected = log10(p);
+        }
+        
+        // Must be the same down to the last bit.
+        REQUIRE(fast == expected);
+        intervals++;
+    });
+    REQUIRE(intervals > 0);
+    
+    double cap = TestableMinimizerMapper::faster_cap(minimizers, minimizers_explored, sequence, quality);
+    REQUIRE(!std::isinf(cap));
+}
+
+TEST_CASE("MinimizerMapper::chain_colinear finds the best colinear chain", "[giraffe][mapping]") {
+
+    // Three 20 bp nodes in a line
+    VG graph;
+    Node* n1 = graph.create_node("GATTACAGATTACAGATTAC");
+    Node* n2 = graph.create_node("CATTAGCATTAGCATTAGCA");
+    Node* n3 = graph.create_node("TTGACCTTGACCTTGACCTT");
+    graph.create_edge(n1, n2);
+    graph.create_edge(n2, n3);
+
+    CactusSnarlFinder bubble_finder(graph);
+    SnarlManager snarl_manager = bubble_finder.find_snarls();
+    MinimumDistanceIndex distance_index(&graph, &snarl_manager);
+
+    gbwtgraph::GBWTGraph gbwt_graph;
+    gbwtgraph::DefaultMinimizerIndex minimizer_index;
+    TestableMinimizerMapper mapper(gbwt_graph, minimizer_index, distance_index);
+
+    vector<TestableMinimizerMapper::ChainItem> items;
+    int32_t best_score, second_best_score;
+
+    SECTION("No items make an empty chain") {
+        vector<size_t> chain = mapper.chain_colinear(items, true, best_score, second_best_score);
+        REQUIRE(chain.empty());
+        REQUIRE(best_score == 0);
+        REQUIRE(second_best_score == 0);
+    }
+
+    SECTION("Items that overlap in the read can only be chained if overlap is allowed") {
+        // Both place 20 read bases 10 bp apart on node 1.
+        items.push_back({ 0, 20, 0, make_pos_t(1, false, 0), 20 });
+        items.push_back({ 10, 30, 10, make_pos_t(1, false, 10), 20 });
+
+        SECTION("With overlap, the shared bases are only counted once") {
+            vector<size_t> chain = mapper.chain_colinear(items, true, best_score, second_best_score);
+            REQUIRE(chain == vector<size_t>({0, 1}));
+            REQUIRE(best_score == 30);
+            REQUIRE(second_best_score == 0);
+        }
+
+        SECTION("Without overlap, each item is its own chain") {
+            vector<size_t> chain = mapper.chain_colinear(items, false, best_score, second_best_score);
+            REQUIRE(chain == vector<size_t>({0}));
+            REQUIRE(best_score == 20);
+            REQUIRE(second_best_score == 20);
+        }
+    }
+
+    SECTION("Items separated in the read chain across nodes") {
+        // Read and graph distances agree from the first item to the second.
+        items.push_back({ 0, 10, 0, make_pos_t(1, false, 0), 10 });
+        items.push_back({ 20, 30, 20, make_pos_t(2, false, 0), 10 });
+        // The third needs a 3 bp deletion, which costs 6 + 2 * 1.
+        items.push_back({ 40, 50, 40, make_pos_t(3, false, 3), 10 });
+        // The fourth can only follow the first, with an indel too big to pay for.
+        items.push_back({ 60, 70, 60, make_pos_t(1, false, 5), 15 });
 
+        SECTION("The best chain pays for its indels") {
+            vector<size_t> chain = mapper.chain_colinear(items, false, best_score, second_best_score);
+            REQUIRE(chain == vector<size_t>({0, 1, 2}));
+            REQUIRE(best_score == 22);
+            REQUIRE(second_best_score == 15);
+        }
 
+        SECTION("Overlap does not matter when the items do not overlap") {
+            vector<size_t> chain = mapper.chain_colinear(items, true, best_score, second_best_score);
+            REQUIRE(chain == vector<size_t>({0, 1, 2}));
+            REQUIRE(best_score == 22);
+            REQUIRE(second_best_score == 15);
+        }
 
+        SECTION("Indels longer than max_chain_indel break the chain") {
+            mapper.max_chain_indel = 2;
+            vector<size_t> chain = mapper.chain_colinear(items, false, best_score, second_best_score);
+            REQUIRE(chain == vector<size_t>({0, 1}));
+            REQUIRE(best_score == 20);
+            REQUIRE(second_best_score == 15);
+        }
+    }
+}
 
 }
 
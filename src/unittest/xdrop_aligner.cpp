@@ -867,6 +867,76 @@ TEST_CASE("QualAdjXdropAligner uses quality adjusted full length bonuses",
     REQUIRE(aln1.score() == 1);
     REQUIRE(aln2.score() == 1);
 }
+
+TEST_CASE("XdropAligner gives the same alignment when it reuses a packed query", "[xdrop][alignment][mapping][pinned]") {
+    
+    VG graph;
+    
+    TestAligner aligner_source;
+    aligner_source.set_alignment_scores(1, 4, 6, 1, 10);
+    const Aligner& aligner = *aligner_source.get_regular_aligner();
+    
+    Node* n0 = graph.create_node("AGTG");
+    Node* n1 = graph.create_node("C");
+    Node* n2 = graph.create_node("A");
+    Node* n3 = graph.create_node("TGAACT");
+    
+    graph.create_edge(n0, n1);
+    graph.create_edge(n0, n2);
+    graph.create_edge(n1, n3);
+    graph.create_edge(n2, n3);
+    
+    Alignment aln;
+    aln.set_sequence("AGTGCTGTACT");
+    aligner.align_pinned(aln, graph, true, true);
+    string first = pb2json(aln);
+    
+    SECTION("Aligning the same read again gives the same alignment") {
+        Alignment again;
+        again.set_sequence(aln.sequence());
+        aligner.align_pinned(again, graph, true, true);
+        REQUIRE(pb2json(again) == first);
+    }
+    
+    SECTION("Aligning the read again after enough other reads to flush the packed queries gives the same alignment") {
+        for (size_t i = 1; i <= 40; i++) {
+            Alignment other;
+            other.set_sequence("AGTG" + string(i, 'T'));
+            aligner.align_pinned(other, graph, i % 2 == 0, true);
+        }
+        Alignment again;
+        again.set_sequence(aln.sequence());
+        aligner.align_pinned(again, graph, true, true);
+        REQUIRE(pb2json(again) == first);
+    }
+}
+
+TEST_CASE("QualAdjXdropAligner does not reuse a packed query for a read with different qualities", "[xdrop][alignment][mapping][pinned]") {
+    
+    bdsg::HashGraph graph;
+    
+    handle_t h0 = graph.create_handle("AAGGG");
+    
+    Alignment high;
+    high.set_sequence("AC");
+    high.set_quality("HH");
+    alignment_quality_char_to_short(high);
+    
+    Alignment low;
+    low.set_sequence("AC");
+    low.set_quality("H#");
+    alignment_quality_char_to_short(low);
+    
+    TestAligner aligner_source;
+    aligner_source.set_alignment_scores(1, 4, 6, 1, 5);
+    const QualAdjAligner& aligner = *aligner_source.get_qual_adj_aligner();
+    
+    aligner.align_pinned(high, graph, true, true);
+    aligner.align_pinned(low, graph, true, true);
+    
+    // The mismatch should cost less at the low quality base
+    REQUIRE(low.score() > high.score());
+}
    
 }
 }
@@ -40,9 +40,17 @@ XdropAligner& XdropAligner::operator=(const XdropAligner& other)
         if (dz) {
             dz_destroy(dz);
         }
+        if (query_dz) {
+            dz_destroy(query_dz);
+        }
         dz = dz_init(other.dz->matrix,
                      *((const uint16_t*) &other.dz->giv),
                      *((const uint16_t*) &other.dz->gev));
+        query_dz = dz_init(other.dz->matrix,
+                           *((const uint16_t*) &other.dz->giv),
+                           *((const uint16_t*) &other.dz->gev));
+        // the other aligner's packed queries live in its own arena
+        num_cached_queries = 0;
     }
 
 	return *this;
@@ -61,6 +69,14 @@ XdropAligner& XdropAligner::operator=(XdropAligner&& other)
         }
         dz = other.dz;
         other.dz = nullptr;
+        if (query_dz) {
+            dz_destroy(query_dz);
+        }
+        query_dz = other.query_dz;
+        other.query_dz = nullptr;
+        query_cache = std::move(other.query_cache);
+        num_cached_queries = other.num_cached_queries;
+        other.num_cached_queries = 0;
     }
 
 	return *this;
@@ -73,21 +89,23 @@ XdropAligner::XdropAligner(const int8_t* _score_matrix, int8_t _gap_open, int8_t
     assert(_gap_open - _gap_extension >= 0);
     assert(_gap_extension > 0);
     dz = dz_init(_score_matrix, _gap_open - _gap_extension, _gap_extension);
+    query_dz = dz_init(_score_matrix, _gap_open - _gap_extension, _gap_extension);
 }
 
 XdropAligner::~XdropAligner(void)
 {
     dz_destroy(dz);
+    dz_destroy(query_dz);
 }
 
 dz_query_s* XdropAligner::pack_query_forward(const char* seq, const uint8_t* qual,
                                              int8_t full_length_bonus, size_t len) {
-    return dz_pack_query_forward(dz, seq, full_length_bonus, len);
+    return dz_pack_query_forward(query_dz, seq, full_length_bonus, len);
 }
 
 dz_query_s* XdropAligner::pack_query_reverse(const char* seq, const uint8_t* qual,
                                              int8_t full_length_bonus, size_t len) {
-    return dz_pack_query_reverse(dz, seq, full_length_bonus, len);
+    return dz_pack_query_reverse(query_dz, seq, full_length_bonus, len);
 }
 
 const dz_forefront_s* XdropAligner::scan(const dz_query_s* query, const dz_forefront_s** forefronts,
@@ -110,6 +128,10 @@ void XdropAligner::flush() {
     dz_flush(dz);
 }
 
+void XdropAligner::flush_queries() {
+    dz_flush(query_dz);
+}
+
 /**
  * end of xdrop_aligner.cpp
  */
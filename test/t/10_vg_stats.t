@@ -5,7 +5,7 @@ BASH_TAP_ROOT=../deps/bash-tap
 
 PATH=../bin:$PATH # for vg
 
-plan tests 18
+plan tests 19
 
 vg construct -r 1mb1kgp/z.fa -v 1mb1kgp/z.vcf.gz >z.vg
 #is $? 0 "construction of a 1 megabase graph from the 1000 Genomes succeeds"
@@ -43,7 +43,10 @@ is "$(vg stats -a x.gam x.vg | md5sum | cut -f 1 -d\ )" "$(md5sum correct/10_vg_
 is "$(vg stats -z x.vg)" "$(vg stats -z x.xg)" "basic stats agree between graph formats"
 
 is "$(vg stats -a x.gam | grep 'Total alignments')" "Total alignments: 100" "stats can be computed for GAM files without graphs"
-rm -f x.vg x.xg x.gcsa x.gam
+
+vg convert -G x.gam x.vg > x.gaf
+is "$(vg stats -g x.gaf x.vg | grep -E 'Total alignments|nodes:')" "$(vg stats -a x.gam x.vg | grep -E 'Total alignments|nodes:')" "stats can be computed for GAF files"
+rm -f x.vg x.xg x.gcsa x.gam x.gaf
 
 vg construct -v tiny/tiny.vcf.gz -r tiny/tiny.fa | vg view -g - > tiny_names.gfa
 printf "P\tref.1\t1+,3+,5+,6+,8+,9+,11+,12+,14+,15+\t8M,1M,1M,3M,1M,19M,1M,4M,1M,11M\n" >> tiny_names.gfa
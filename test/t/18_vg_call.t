@@ -6,7 +6,7 @@ BASH_TAP_ROOT=../deps/bash-tap
 PATH=../bin:$PATH # for vg
 
 
-plan tests 12
+plan tests 16
 
 # Toy example of hand-made pileup (and hand inspected truth) to make sure some
 # obvious (and only obvious) SNPs are detected by vg call
@@ -35,6 +35,15 @@ vg call  mappedminitest_aug.xg -k mappedminitest_aug.pack > calledminitest.vcf
 L_COUNT=$(cat calledminitest.vcf | grep "#" -v | wc -l)
 is "${L_COUNT}" "1" "Called microinversion"
 
+vg pack -x mappedminitest_aug.xg -g mappedminitest_aug.gam -o mappedminitest_aug.pack -P mappedminitest_aug.depth
+vg call  mappedminitest_aug.xg -k mappedminitest_aug.pack -D mappedminitest_aug.depth > calledminitest_depth.vcf
+diff <(grep -v "#" calledminitest.vcf) <(grep -v "#" calledminitest_depth.vcf)
+is "$?" 0 "calling with a precomputed depth index gives the same calls"
+vg view -a mappedminitest_aug.gam | head -n 1 | vg view -JaG - > one_read.gam
+vg pack -x mappedminitest_aug.xg -g one_read.gam -o one_read.pack
+is "$(vg call mappedminitest_aug.xg -k one_read.pack -D mappedminitest_aug.depth 2>&1 >/dev/null | grep -c recomputing)" 1 "a depth index made from a different pack is recomputed"
+rm -f mappedminitest_aug.depth calledminitest_depth.vcf one_read.gam one_read.pack
+
 rm -f miniFastaGraph.vg miniFasta.gam miniFastaGraph.gam calledminitest.vcf  miniFastaGraph.xg miniFastaGraph.gcsa mappedminitest_aug.vg mappedminitest_aug.gam mappedminitest_aug.xg mappedminitest_aug.pack miniFastaGraph.gcsa.lcp
 
 vg construct -r inverting/miniFasta.fa -v inverting/miniFasta_VCFinversion.vcf.gz -S > miniFastaGraph.vg
@@ -87,6 +96,15 @@ REF_COUNT_A=$(grep "0/0" HGSVC2.vcf | wc -l)
 # this probably doesn't need to be exact (coincidence?), but it works now
 is "${REF_COUNT_V}" "${REF_COUNT_A}" "Same number of reference calls with -a as with -v"
 
+# Spilling sorted runs of variants to disk should not change the output
+vg call HGSVC_alts.xg -k HGSVC_alts.pack -s HG00514 -a -S 10 > HGSVC3.vcf
+diff HGSVC2.vcf HGSVC3.vcf
+is "$?" "0" "Spilling variants to temporary files produces the same VCF"
+# One variant per run makes more runs than are merged at once
+vg call HGSVC_alts.xg -k HGSVC_alts.pack -s HG00514 -a -S 1 > HGSVC4.vcf
+diff HGSVC2.vcf HGSVC4.vcf
+is "$?" "0" "Merging spilled variants in several passes produces the same VCF"
+
 # Output snarl traversals into a GBWT then genotype that
 vg call HGSVC_alts.xg -k HGSVC_alts.pack -s HG00514 -T | gzip > HGSVC_travs.gaf.gz
 vg index HGSVC_alts.xg -F HGSVC_travs.gaf.gz -G HGSVC_travs.gbwt
@@ -106,7 +124,7 @@ LESS_THREE=$(if (( $DIFF_COUNT < 3 )); then echo 1; else echo 0; fi)
 # there is some wobble here
 is "${LESS_THREE}" "1" "Fewer than 3 differences between allales called via traversals or directly"
 
-rm -f HGSVC_alts.vg HGSVC_alts.xg HGSVC_alts.pack HGSVC.vcf baseline_gts.txt gts.txt HGSVC1.vcf HGSVC2.vcf HGSVC_travs.gaf.gz HGSVC_travs.gbwt HGSVC_travs.vcf HGSVC_direct.vcf baseline_gts1.txt gts1.txt gts-travs.txt gts-direct.txt calls-travs.txt calls-direct.txt
+rm -f HGSVC_alts.vg HGSVC_alts.xg HGSVC_alts.pack HGSVC.vcf baseline_gts.txt gts.txt HGSVC1.vcf HGSVC2.vcf HGSVC3.vcf HGSVC4.vcf HGSVC_travs.gaf.gz HGSVC_travs.gbwt HGSVC_travs.vcf HGSVC_direct.vcf baseline_gts1.txt gts1.txt gts-travs.txt gts-direct.txt calls-travs.txt calls-direct.txt
 
 vg construct -a -r small/x.fa -v small/x.vcf.gz > x.vg
 vg index -x x.xg x.vg -L
@@ -5,7 +5,7 @@ BASH_TAP_ROOT=../deps/bash-tap
 
 PATH=../bin:$PATH # for vg
 
-plan tests 18
+plan tests 22
 
 vg construct -m 1000 -r tiny/tiny.fa >flat.vg
 vg view flat.vg| sed 's/CAAATAAGGCTTGGAAATTTTCTGGAGTTCTATTATATTCCAACTCTCTG/CAAATAAGGCTTGGAAATTTTCTGGAGATCTATTATACTCCAACTCTCTG/' | vg view -Fv - >2snp.vg
@@ -68,7 +68,23 @@ is $x $y "pack computes the same total edge coverage as pileup"
 x=$(vg pack -x tiny.xg -i tiny.pack -D | grep -v from | awk '{sum+=$5} END {print sum}')
 is $x $y "pack stores the correct edge pileup to disk"
 
-rm -f tiny.vg tiny.xg tiny.gam tiny.vgpu tiny.pack
+vg pack -x tiny.xg -g pileup/tiny.gam -e -C 2 -o tiny.chunked.pack
+x=$(vg pack -x tiny.xg -i tiny.pack -d -D -u | md5sum)
+y=$(vg pack -x tiny.xg -i tiny.chunked.pack -d -D -u | md5sum)
+is "$x" "$y" "chunked packs load the same coverage as whole packs"
+vg pack -x tiny.xg -i tiny.chunked.pack -i tiny.chunked.pack -o tiny.2x.pack
+x=$(vg pack -x tiny.xg -i tiny.2x.pack -d | tail -n+2 | awk '{sum+=$4} END {print sum}')
+y=$(vg pack -x tiny.xg -i tiny.pack -d | tail -n+2 | awk '{sum+=2*$4} END {print sum}')
+is $x $y "chunked packs can be merged"
+
+vg pack -x tiny.xg -i tiny.pack -i tiny.2x.pack -M tiny.matrix -d > tiny.matrix.tsv
+x=$(tail -n+2 tiny.matrix.tsv | awk '{sum+=$4} END {print sum}')
+y=$(vg pack -x tiny.xg -i tiny.pack -d | tail -n+2 | awk '{sum+=$4} END {print sum}')
+is $x $y "coverage matrix holds the first sample's coverage"
+x=$(tail -n+2 tiny.matrix.tsv | awk '$5 != 2 * $4' | wc -l)
+is $x 0 "coverage matrix holds the second sample's coverage"
+
+rm -f tiny.vg tiny.xg tiny.gam tiny.vgpu tiny.pack tiny.chunked.pack tiny.2x.pack tiny.matrix tiny.matrix.tsv
 
 vg construct -r small/x.fa -v small/x.vcf.gz > x.vg
 vg index -x x.xg x.vg
@@ -5,7 +5,7 @@ BASH_TAP_ROOT=../deps/bash-tap
 
 PATH=../bin:$PATH # for vg
 
-plan tests 91
+plan tests 93
 
 
 # Build vg graphs for two chromosomes
@@ -25,6 +25,10 @@ vg index -G x2.gbwt -v small/xy2.vcf.gz x.vg
 is $? 0 "chromosome X GBWT with vg index"
 cmp x.gbwt x2.gbwt
 is $? 0 "identical construction results with vg gbwt and vg index"
+vg gbwt -x x.vg -o x3.gbwt --stream-parse -v small/xy2.vcf.gz
+is $? 0 "chromosome X GBWT without VCF parse files"
+cmp x.gbwt x3.gbwt
+is $? 0 "identical construction results with and without VCF parse files"
 vg gbwt -x x.vg -o parse --parse-only -v small/xy2.vcf.gz
 is $? 0 "chromosome X VCF parse"
 ../deps/gbwt/build_gbwt -p -r parse_x > /dev/null 2> /dev/null
@@ -42,7 +46,7 @@ is $(vg gbwt -T x.gbwt | wc -l) 2 "chromosome X: 2 thread names"
 is $(vg gbwt -C -L x.gbwt | wc -l) 1 "chromosome X: 1 contig name"
 is $(vg gbwt -S -L x.gbwt | wc -l) 1 "chromosome X: 1 sample name"
 
-rm -f x.gbwt x2.gbwt x.bare.gbwt parse_x.gbwt
+rm -f x.gbwt x2.gbwt x3.gbwt x.bare.gbwt parse_x.gbwt
 rm -f parse_x parse_x_0_1
 
 
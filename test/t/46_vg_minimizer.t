@@ -5,7 +5,7 @@ BASH_TAP_ROOT=../deps/bash-tap
 
 PATH=../bin:$PATH # for vg
 
-plan tests 14
+plan tests 16
 
 
 # Indexing a single graph
@@ -49,7 +49,13 @@ is $? 0 "construction with payload"
 vg view --extract-tag MinimizerIndex x.mi > x.extracted.mi
 is $(md5sum x.extracted.mi | cut -f 1 -d\ ) 58a6780c18921e4f6701b57fdb9c2e44 "construction is deterministic"
 
-rm -f x.vg x.xg x.gbwt x.snarls x.dist x.mi x.extracted.mi x.gg
+# Partitioned construction
+vg minimizer -t 1 -p -i x.mi -g x.gbwt x.xg 2> x.log
+vg minimizer -t 2 -P -p -i x.mi -g x.gbwt x.xg 2> x.partitioned.log
+is $? 0 "partitioned construction"
+is "$(grep "keys" x.partitioned.log)" "$(grep "keys" x.log)" "partitioned construction finds the same minimizers"
+
+rm -f x.vg x.xg x.gbwt x.snarls x.dist x.mi x.extracted.mi x.gg x.log x.partitioned.log
 
 
 # Indexing two graphs
@@ -5,7 +5,7 @@ BASH_TAP_ROOT=../deps/bash-tap
 
 PATH=../bin:$PATH # for vg
 
-plan tests 20
+plan tests 28
 
 vg construct -a -r small/x.fa -v small/x.vcf.gz >x.vg
 vg index -x x.xg -G x.gbwt -v small/x.vcf.gz x.vg
@@ -21,7 +21,17 @@ vg minimizer -k 29 -b -s 18 -g x.gbwt -i x.sync x.xg
 vg giraffe -x x.xg -H x.gbwt -m x.sync -d x.dist -f reads/small.middle.ref.fq > mapped.sync.gam
 is "${?}" "0" "a read can be mapped with syncmer indexes without crashing"
 
-rm -f x.vg x.xg x.gbwt x.snarls x.min x.sync x.dist x.gg
+# GAF output skips the annotations GAF does not carry, which must not change it
+vg giraffe -x x.xg -H x.gbwt -m x.min -d x.dist -f small/x.fa_1.fastq -f small/x.fa_2.fastq --fragment-mean 300 --fragment-stdev 100 -o gaf > paired.direct.gaf
+vg giraffe -x x.xg -H x.gbwt -m x.min -d x.dist -f small/x.fa_1.fastq -f small/x.fa_2.fastq --fragment-mean 300 --fragment-stdev 100 > paired.annotated.gam
+vg convert x.xg -G paired.annotated.gam > paired.converted.gaf
+is "$(sort paired.direct.gaf | md5sum)" "$(sort paired.converted.gaf | md5sum)" "GAF output is the same as converting GAM output to GAF"
+
+# The cached rescue subgraphs contain the uncached ones, so rescue must find the same alignments
+vg giraffe -x x.xg -H x.gbwt -m x.min -d x.dist -f small/x.fa_1.fastq -f small/x.fa_2.fastq --fragment-mean 300 --fragment-stdev 100 --rescue-cache 1000 > paired.cached.gam
+is "$(vg view -aj paired.cached.gam | sort | md5sum)" "$(vg view -aj paired.annotated.gam | sort | md5sum)" "caching rescue subgraphs does not change paired mappings"
+
+rm -f x.vg x.xg x.gbwt x.snarls x.min x.sync x.dist x.gg paired.direct.gaf paired.annotated.gam paired.converted.gaf paired.cached.gam
 
 cp small/x.fa .
 cp small/x.vcf.gz .
@@ -54,6 +64,22 @@ rm -rf mapped1.gam mapped1.json mapped2.gam mapped2.json mapped.sync.gam mapped.
 vg giraffe x.fa x.vcf.gz -f small/x.fa_1.fastq > single.gam
 is "$(vg view -aj single.gam | jq -c 'select((.fragment_next | not) and (.fragment_prev | not))' | wc -l)" "1000" "unpaired reads lack cross-references"
 
+vg giraffe x.fa x.vcf.gz -f small/x.fa_1.fastq --adaptive-clusters 100 > adaptive.gam 2> adaptive.log
+is "$(vg view -aj adaptive.gam | wc -l)" "1000" "mapping with adaptive cluster thresholds produces all the reads"
+is "$(grep -c '^Adaptive cluster thresholds: learned from' adaptive.log)" "1" "adaptive cluster thresholds are learned and reported"
+vg giraffe x.fa x.vcf.gz -f small/x.fa_1.fastq -f small/x.fa_2.fastq --adaptive-clusters 100 > /dev/null 2>&1
+is "$?" "1" "adaptive cluster thresholds are rejected for paired reads"
+
+# Make a long read with a deletion and an insertion in it
+SEQ="$(grep -v '>' x.fa | tr -d '\n' | head -c 800)"
+LONG="${SEQ:0:300}${SEQ:310:200}GATTACA${SEQ:510:290}"
+printf "@long\n%s\n+\n%s\n" "${LONG}" "$(head -c ${#LONG} < /dev/zero | tr '\0' 'I')" > long.fq
+vg giraffe x.fa x.vcf.gz -f long.fq --long-reads > long.gam
+is "$(vg view -aj long.gam | jq '.identity > 0.95')" "true" "a long read with indels can be mapped by chaining"
+is "$(vg view -aj long.gam | jq '.annotation.chained_extensions > 1')" "true" "a long read with indels is mapped by chaining gapless extensions"
+vg giraffe x.fa x.vcf.gz -f long.fq --long-reads -O > long.nodp.gam
+is "$(vg view -aj long.nodp.gam | jq '.annotation.chained_extensions')" "null" "long read chaining is not used when gapped alignment is disabled"
+
 vg giraffe x.fa x.vcf.gz -f small/x.fa_1.fastq -f small/x.fa_1.fastq --fragment-mean 300 --fragment-stdev 100 > paired.gam
 is "$(vg view -aj paired.gam | jq -c 'select((.fragment_next | not) and (.fragment_prev | not))' | wc -l)" "0" "paired reads have cross-references"
 
@@ -73,7 +99,7 @@ is "$(cat surjected.sam | grep -v '^@' | cut -f 1 | sort | uniq | wc -l)" "2" "s
 is "$(cat surjected.sam | grep -v '^@' | cut -f 7)" "$(printf '*\n*')" "surjection of unpaired reads to SAM produces absent partner contigs"
 is "$(cat surjected.sam | grep -v '^@' | sort -k4 | cut -f 2)" "$(printf '0\n16')" "surjection of unpaired reads to SAM produces correct flags"
 
-rm -f x.vg x.gbwt x.gg x.snarls x.min x.dist x.gg x.fa x.fa.fai x.vcf.gz x.vcf.gz.tbi single.gam paired.gam surjected.sam
+rm -f x.vg x.gbwt x.gg x.snarls x.min x.dist x.gg x.fa x.fa.fai x.vcf.gz x.vcf.gz.tbi single.gam adaptive.gam adaptive.log long.fq long.gam long.nodp.gam paired.gam surjected.sam
 
 cp small/xy.fa .
 cp small/xy.vcf.gz .